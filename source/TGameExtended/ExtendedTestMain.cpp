@@ -19,6 +19,8 @@ protected:
 Sprite* sampleSprite = NULL;
 Sprite* anotherSprite = NULL;
 FontSprite* fs = NULL;
+// seconds per terrain frame, [animation] frame-interval in the config
+SettingRef<double>* frameInterval = NULL;
 
 bool TestGame::startup()
 {
@@ -44,6 +46,8 @@ bool TestGame::startup()
   SoundManager* sm = getSoundManager();
   sm->quickPlay(L"rollingSound");
 
+  frameInterval = new SettingRef<double>(g_GlobalSettings.getSettings(), L"animation", L"frame-interval", 1.0);
+
   return true;
 }
 
@@ -51,6 +55,7 @@ void TestGame::shutdown()
 {
   SAFE_DELETE(anotherSprite);
   SAFE_DELETE(sampleSprite);
+  SAFE_DELETE(frameInterval);
 
   ExtendedFramework::shutdown();
 }
@@ -62,7 +67,7 @@ bool TestGame::frame(const double timeSinceLast)
   if(sampleSprite)
   {
     span += timeSinceLast;
-    if(span > 1.0f)
+    if(span > frameInterval->get())
     {
       span = 0.0f;
       anotherSprite->changeFrame(CHANGE_TO_NEXT_FRAME);
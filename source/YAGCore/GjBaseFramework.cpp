@@ -34,6 +34,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "GjBaseFramework.h"
 #include "GjUnicodeUtils.h"
 #include "GjResourceManagement.h"
+#include "GjVFSResourceStore.h"
 #include "GjIniFiles.h"
 #include "GjInputManagerDX.h"
 #include "GjKeyCodes.h"
@@ -167,10 +168,25 @@ bool BasicFramework::startup()
     // 
     if(bfs::exists(configFile))
       g_GlobalSettings.loadFrom(IniSettingsStore(), configFile);
+
+    // .ini files loaded from here on get snapshots, if the config
+    // says where to keep them
+    MultipleSettings const& settings = gs->getSettings();
+    if(settings.exists(CONFIG_SNAPSHOT_SECTION) &&
+       settings[CONFIG_SNAPSHOT_SECTION].exists(CONFIG_SNAPSHOT_FOLDER))
+      IniSnapshot::setFolder(string_utils::conditional_append_copy(
+        NativeApplication::ApplicationPath(), '\\') +
+        settings[CONFIG_SNAPSHOT_SECTION][CONFIG_SNAPSHOT_FOLDER].getValue());
   }
 
-  // make sure the singletons are initialized
+  // make sure the singletons are initialized. resource-folders entries
+  // may name archives as well as folders.
+  g_ResourceManager.registerStore(VFS_ARCHIVE_EXTENSION, &vfs::VolumeStore::create);
   g_ResourceManager.initialize(gs->getSettings());
+#ifdef _DEBUG
+  // assets get edited while the game runs, pick up new ones as they appear
+  g_ResourceManager.setWatching(true);
+#endif
 
   // create the device manager, and initialize it
   mDeviceManager = new InputDeviceManagerDX();
@@ -241,6 +257,8 @@ void BasicFramework::perform()
 
   double timeSinceLast = mGTimer->getElapsedTime();
   mDeviceManager->update();
+  // callbacks of the resource lookups that finished since the last frame
+  g_ResourceManager.update();
 
   // calculate FPS, we might want to display it
   if(mFPSTracker.update(timeSinceLast))
@@ -98,6 +98,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 // library includes
 #pragma comment(lib, "YAGSupport.lib")
+#pragma comment(lib, "YAGVFS.lib")
 #pragma comment(lib, "YAGDisplay.lib")
 #pragma comment(lib, "YAGInput.lib")
 #pragma comment(lib, "YAGCore.lib")
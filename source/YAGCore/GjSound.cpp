@@ -132,10 +132,10 @@ bool SoundManager::initialize(HWND hWnd, MultipleSettings& settings)
       // load the file list
       if(settings.exists(SOUND_SECTION))
       {
-        Settings section = settings[SOUND_SECTION];
+        Settings const& section = settings[SOUND_SECTION];
         for(int i = 0; i < static_cast<int>(section.size()); i++)
         {
-          Setting item = section[i];
+          Setting const& item = section[i];
           add(item.getName(), item.getValue());
         }
       }
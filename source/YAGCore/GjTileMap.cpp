@@ -50,21 +50,21 @@ void TerrainManager::loadIsoSettings(MultipleSettings& settings)
 {
   if(settings.exists(ISOMETRIC_SECTION_INDICES))
   {
-    Settings section = settings[ISOMETRIC_SECTION_INDICES];
+    Settings const& section = settings[ISOMETRIC_SECTION_INDICES];
     for(int i = 0; i < static_cast<int>(section.size()); i++)
     {
-      Setting& item = section[i];
+      Setting const& item = section[i];
       mIndices[item.getName()] = _wtoi(item.getValue().c_str());
     }
   }
 
   if(settings.exists(ISOMETRIC_SECTION_TERRAIN))
   {
-    Settings section = settings[ISOMETRIC_SECTION_TERRAIN];
+    Settings const& section = settings[ISOMETRIC_SECTION_TERRAIN];
     stringsList items;
     for(int i = 0; i < static_cast<int>(section.size()); i++)
     {
-      Setting& item = section[i];
+      Setting const& item = section[i];
       items.clear();
       WideString value = item.getValue();
 
@@ -76,7 +76,7 @@ void TerrainManager::loadIsoSettings(MultipleSettings& settings)
   mTileSize = Size(64, 31);
   if(settings.exists(ISOMETRIC_SECTION_SETTINGS))
   {
-    Settings section = settings[ISOMETRIC_SECTION_SETTINGS];
+    Settings const& section = settings[ISOMETRIC_SECTION_SETTINGS];
     if(section.exists(L"width"))
       mTileSize.width = string_utils::parse_int(section[L"width"].getValue());
     if(section.exists(L"height"))
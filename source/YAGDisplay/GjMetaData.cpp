@@ -42,6 +42,9 @@ using namespace yaglib;
 
 void MetaDataManager::initialize()
 {
+  if(loadManifest(g_ResourceManager.getManifest()))
+    return;
+
   loadTextureMeta();
   loadSpriteMeta();
 }
@@ -68,25 +71,178 @@ SpriteMeta const* MetaDataManager::getSpriteMeta(const WideString spriteName) co
   return subj != mSprites.end() ? &(subj->second) : NULL;
 }
 
+// frames are kept both in pixels and in texels
+static void addFrame(TextureMeta& tm, const GJRECT& r)
+{
+  GJRECT r2 = r;
+  r2.scale(1/static_cast<GJFLOAT>(tm.size.width), 1/static_cast<GJFLOAT>(tm.size.height));
+  //
+  tm.byPixels.add(r);
+  tm.byTexels.add(r2);
+}
+
+// the .info files the metadata is parsed from, by content, in the order
+// they're found. the manifest's copy of the metadata is only used while
+// they all still read the same, anything added, edited or moved since
+// (including groups the manifest didn't know about) has them parsed.
+static void fingerprintMetaFiles(std::vector<unsigned int>& prints)
+{
+  const WideString fileNames[] = { IMAGE_CONFIG_FILENAME, SPRITES_CONFIG_FILENAME };
+  for(int i = 0; i < 2; i++)
+  {
+    DataPacks packs;
+    g_ResourceManager.lookup(packs, fileNames[i]);
+    prints.push_back(static_cast<unsigned int>(packs.size()));
+    for(DataPacks::iterator iter = packs.begin(); iter != packs.end(); iter++)
+    {
+      // FNV-1a
+      unsigned int hash = 2166136261u;
+      const Byte* data = static_cast<const Byte*>(iter->getData());
+      for(size_t j = 0; j < iter->getSize(); j++)
+        hash = (hash ^ data[j]) * 16777619u;
+      prints.push_back(hash);
+    }
+  }
+}
+
+void MetaDataManager::writeManifest(ResourceManifest& manifest) const
+{
+  ManifestWriter writer;
+  std::vector<unsigned int> prints;
+  fingerprintMetaFiles(prints);
+  writer.writeInt(static_cast<int>(prints.size()));
+  for(std::vector<unsigned int>::iterator iter = prints.begin(); iter != prints.end(); iter++)
+    writer.writeInt(static_cast<int>(*iter));
+
+  // texture file names are resolved again when read back, the qualified
+  // names here are only good for this machine
+  writer.writeInt(static_cast<int>(mTextures.size()));
+  for(TextureMetaMap::const_iterator iter = mTextures.begin(); iter != mTextures.end(); iter++)
+  {
+    TextureMeta const& tm = iter->second;
+    writer.writeString(iter->first);
+    writer.writeInt(tm.size.width);
+    writer.writeInt(tm.size.height);
+    writer.writeInt((int)tm.transparentColor);
+    writer.writeInt(static_cast<int>(tm.byPixels.size()));
+    for(int i = 0; i < static_cast<int>(tm.byPixels.size()); i++)
+    {
+      GJRECT const& r = tm.byPixels[i];
+      writer.writeFloat(static_cast<float>(r.left));
+      writer.writeFloat(static_cast<float>(r.top));
+      writer.writeFloat(static_cast<float>(r.right));
+      writer.writeFloat(static_cast<float>(r.bottom));
+    }
+  }
+
+  writer.writeInt(static_cast<int>(mTextureAliases.size()));
+  for(StringMap::const_iterator iter = mTextureAliases.begin(); iter != mTextureAliases.end(); iter++)
+  {
+    writer.writeString(iter->first);
+    writer.writeString(iter->second);
+  }
+
+  writer.writeInt(static_cast<int>(mSprites.size()));
+  for(SpriteMetaMap::const_iterator iter = mSprites.begin(); iter != mSprites.end(); iter++)
+  {
+    writer.writeString(iter->first);
+    writer.writeString(iter->second.textureName);
+    writer.writeInt(iter->second.firstFrame);
+    writer.writeInt(iter->second.lastFrame);
+  }
+
+  manifest.setBlock(MANIFEST_META_BLOCK, writer);
+}
+
+bool MetaDataManager::loadManifest(const ResourceManifest& manifest)
+{
+  ManifestReader reader;
+  if(!manifest.getBlock(MANIFEST_META_BLOCK, reader))
+    return false;
+
+  std::vector<unsigned int> prints;
+  fingerprintMetaFiles(prints);
+  int count = reader.readInt();
+  if(count != static_cast<int>(prints.size()))
+    return false;
+  for(int i = 0; i < count; i++)
+    if(static_cast<unsigned int>(reader.readInt()) != prints[i])
+      return false;
+
+  count = reader.readInt();
+  for(int i = 0; (i < count) && !reader.failed(); i++)
+  {
+    WideString textureName = reader.readString();
+    TextureMeta tm;
+    tm.size.width = reader.readInt();
+    tm.size.height = reader.readInt();
+    tm.transparentColor = ColorQuad(reader.readInt());
+
+    int frameCount = reader.readInt();
+    for(int j = 0; (j < frameCount) && !reader.failed(); j++)
+    {
+      GJFLOAT left = reader.readFloat(), top = reader.readFloat();
+      GJFLOAT right = reader.readFloat(), bottom = reader.readFloat();
+      addFrame(tm, GJRECT(left, top, right, bottom));
+    }
+
+    // a probe of the resource folders' indexes, no disk access
+    DataPack dp;
+    if(g_ResourceManager.lookup(dp, textureName, GROUP_NAME_ANY, true))
+    {
+      tm.fileName = dp.getFileName();
+      mTextures[textureName] = tm;
+    }
+  }
+
+  count = reader.readInt();
+  for(int i = 0; (i < count) && !reader.failed(); i++)
+  {
+    WideString alias = reader.readString();
+    mTextureAliases[alias] = reader.readString();
+  }
+
+  count = reader.readInt();
+  for(int i = 0; (i < count) && !reader.failed(); i++)
+  {
+    WideString spriteName = reader.readString();
+    WideString textureName = reader.readString();
+    int firstFrame = reader.readInt();
+    int lastFrame = reader.readInt();
+    mSprites[spriteName] = SpriteMeta(textureName, firstFrame, lastFrame);
+  }
+
+  // anything wrong with it and we go back to the .info files
+  if(reader.failed())
+  {
+    shutdown();
+    return false;
+  }
+
+  return true;
+}
+
 void MetaDataManager::loadTextureMeta()
 {
   DataPacks allPacks;
-  g_ResourceManager.lookup(allPacks, IMAGE_CONFIG_FILENAME, true);
+  g_ResourceManager.lookup(allPacks, IMAGE_CONFIG_FILENAME);
   for(DataPacks::iterator iter = allPacks.begin(); iter != allPacks.end(); iter++)
-    processTextureMetaFile(iter->getFileName());
+    processTextureMetaFile(*iter);
 }
 
 #define ENTRY_NAME_TRANSPARENT_COLOR    L"transparentColor"
 #define ENTRY_NAME_WIDTH                L"width"
 #define ENTRY_NAME_HEIGHT               L"height"
 
-void MetaDataManager::processTextureMetaFile(const WideString fileName)
+void MetaDataManager::processTextureMetaFile(const DataPack& dataPack)
 {
-  IniSettings ini(fileName);
+  // parsed straight out of the pack, mapped or in an archive, unless
+  // there's a fresh snapshot of it
+  IniSettings ini(static_cast<const char*>(dataPack.getData()), dataPack.getSize(), dataPack.getFileName());
   for(int i = 0; i < static_cast<int>(ini.size()); i++)
   {
     // skip frame lists, we'll acquire them concurrent with the actual texture info
-    Settings section = ini[i];
+    Settings const& section = ini[i];
     WideString sectionName = section.getName();
     if(sectionName[0] == '#')
       continue;
@@ -115,23 +271,30 @@ void MetaDataManager::processTextureMetaFile(const WideString fileName)
     tm.size.height = string_utils::parse_int(section[ENTRY_NAME_HEIGHT].getValue());
 
     // now we need to parse the frames
-    section = ini[L"#" + sectionName];
-    for(int j = 0; j < static_cast<int>(section.size()); j++)
+    // looked up without creating it, that would move the sections around
+    Settings const* frames = ini.get(L"#" + sectionName, false);
+    for(int j = 0; (frames != NULL) && (j < static_cast<int>(frames->size())); j++)
     {
-      typedef std::vector<WideString> split_list;
-      split_list items;
-      boost::split(items, section[j].getValue(), boost::is_any_of(L","), boost::token_compress_on);
+      // "left,top,right,bottom", read in place.  missing or bad ones
+      // are 0, and whatever is left of a field after the number (the
+      // ".5" of "10.5", say) is skipped along with its comma.  commas
+      // in a row count as one, "1,,2,3,4" is 1 2 3 4
+      const WideString& value = (*frames)[j].getValue();
+      const wchar_t* p = value.data();
+      const wchar_t* end = p + value.size();
+      int coords[4] = { 0, 0, 0, 0 };
+      for(int k = 0; (k < 4) && (p != end); k++)
+      {
+        p = string_utils::from_chars(p, end, coords[k]).ptr;
+        while((p != end) && (*p != ','))
+          p++;
+        while((p != end) && (*p == ','))
+          p++;
+      }
       GJRECT r = GJRECT(
-        static_cast<GJFLOAT>(string_utils::parse_int(items[0])),
-        static_cast<GJFLOAT>(string_utils::parse_int(items[1])),
-        static_cast<GJFLOAT>(string_utils::parse_int(items[2])),
-        static_cast<GJFLOAT>(string_utils::parse_int(items[3]))
-        );
-      GJRECT r2 = r;
-      r2.scale(1/static_cast<GJFLOAT>(tm.size.width), 1/static_cast<GJFLOAT>(tm.size.height));
-      //
-      tm.byPixels.add(r);
-      tm.byTexels.add(r2);
+        static_cast<GJFLOAT>(coords[0]), static_cast<GJFLOAT>(coords[1]),
+        static_cast<GJFLOAT>(coords[2]), static_cast<GJFLOAT>(coords[3]));
+      addFrame(tm, r);
     }
     // all done, store it
     mTextures[sectionName] = tm;
@@ -141,17 +304,17 @@ void MetaDataManager::processTextureMetaFile(const WideString fileName)
 void MetaDataManager::loadSpriteMeta()
 {
   DataPacks allPacks;
-  g_ResourceManager.lookup(allPacks, SPRITES_CONFIG_FILENAME, true);
+  g_ResourceManager.lookup(allPacks, SPRITES_CONFIG_FILENAME);
   for(DataPacks::iterator iter = allPacks.begin(); iter != allPacks.end(); iter++)
-    processSpriteMetaFile(iter->getFileName());
+    processSpriteMetaFile(*iter);
 }
 
-void MetaDataManager::processSpriteMetaFile(const WideString fileName)
+void MetaDataManager::processSpriteMetaFile(const DataPack& dataPack)
 {
-  IniSettings ini(fileName);
+  IniSettings ini(static_cast<const char*>(dataPack.getData()), dataPack.getSize(), dataPack.getFileName());
   if(ini.exists(SPRITES_MAIN_SECTION))
   {
-    Settings section = ini[SPRITES_MAIN_SECTION];
+    Settings const& section = ini[SPRITES_MAIN_SECTION];
     for(int i = 0; i < static_cast<int>(section.size()); i++)
     {
       typedef std::vector<WideString> split_list;
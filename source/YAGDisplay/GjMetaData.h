@@ -43,6 +43,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "GjPoints.h"
 #include "GjRectangles.h"
 #include "GjTemplates.h"
+#include "GjResourceManifest.h"
+#include "GjResourceManagement.h"
 
 namespace yaglib 
 {                    
@@ -80,9 +82,15 @@ struct SpriteMeta
 class MetaDataManager : public Singleton<MetaDataManager>
 {
 public:
+  // the metadata comes from the resource manager's manifest when it has
+  // it and the .info files haven't changed since it was written,
+  // otherwise the .info files of every resource folder are parsed
   void initialize();
   void shutdown();
 
+  // adds the metadata we have to the manifest
+  void writeManifest(ResourceManifest& manifest) const;
+
   TextureMeta const* getTextureMeta(const WideString textureName) const;
   SpriteMeta const* getSpriteMeta(const WideString spriteName) const;
 
@@ -95,10 +103,11 @@ private:
   StringMap mTextureAliases;
   SpriteMetaMap mSprites;
   //
+  bool loadManifest(const ResourceManifest& manifest);
   void loadTextureMeta();
-  void processTextureMetaFile(const WideString fileName);
+  void processTextureMetaFile(const DataPack& dataPack);
   void loadSpriteMeta();
-  void processSpriteMetaFile(const WideString fileName);
+  void processSpriteMetaFile(const DataPack& dataPack);
 };
 
 #define g_MetaDataManager (MetaDataManager::Instance())
@@ -75,6 +75,38 @@ bool bfs::is_file(const WideString& fileName)
 #endif
 }
 
+LONGLONG bfs::last_write_time(const WideString& fileName)
+{
+  try
+  {
+#ifdef YAGLIB_FORCE_BOOST_FILESYSTEM_TO_STD_STRING
+    return static_cast<LONGLONG>(filesystem::last_write_time(UTF8String(fileName).c_str()));
+#else
+    return static_cast<LONGLONG>(filesystem::last_write_time(filesystem::wpath(fileName)));
+#endif
+  }
+  catch(std::exception&)
+  {
+    return -1;
+  }
+}
+
+LONGLONG bfs::file_size(const WideString& fileName)
+{
+  try
+  {
+#ifdef YAGLIB_FORCE_BOOST_FILESYSTEM_TO_STD_STRING
+    return static_cast<LONGLONG>(filesystem::file_size(UTF8String(fileName).c_str()));
+#else
+    return static_cast<LONGLONG>(filesystem::file_size(filesystem::wpath(fileName)));
+#endif
+  }
+  catch(std::exception&)
+  {
+    return -1;
+  }
+}
+
 size_t bfs::list_files(WideString path, std::vector<WideString>& list, 
   const bool wantFiles, const bool wantFolders)
 {
@@ -50,6 +50,10 @@ namespace bfs
   bool is_directory(const WideString& fileName);
   bool is_file(const WideString& fileName);
 
+  // -1 for either if the file or folder can't be found
+  LONGLONG last_write_time(const WideString& fileName);
+  LONGLONG file_size(const WideString& fileName);
+
   size_t list_files(WideString path, std::vector<WideString>& list, 
     const bool wantFiles = true, const bool wantFolders = false);
 
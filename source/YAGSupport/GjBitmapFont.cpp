@@ -323,10 +323,10 @@ bool FontManager::initialize()
   IniSettings settings(configFile);
   if(settings.exists(SECTION_FONTS))
   {
-    Settings fontItems = settings[SECTION_FONTS];
+    Settings const& fontItems = settings[SECTION_FONTS];
     for(int i = 0; i < static_cast<int>(fontItems.size()); i++)
     {
-      Setting item = fontItems[i];
+      Setting const& item = fontItems[i];
       WideString qualifiedName = g_ResourceManager[item.getValue()];
       if(qualifiedName.size() != 0)
         mFonts[item.getValue()] = new BMFont(new BMFontMeta(qualifiedName));
@@ -335,10 +335,10 @@ bool FontManager::initialize()
 
   if(settings.exists(SECTION_ALIASES))
   {
-    Settings aliases = settings[SECTION_ALIASES];
+    Settings const& aliases = settings[SECTION_ALIASES];
     for(int i = 0; i < static_cast<int>(aliases.size()); i++)
     {
-      Setting item = aliases[i];
+      Setting const& item = aliases[i];
       //
       int color = 0xffffffff;
       WideString value = item.getValue();
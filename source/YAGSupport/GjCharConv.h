@@ -0,0 +1,483 @@
+/*
+Yet Another Game Library
+Copyright (c) 2001-2007, Virgilio A. Blones, Jr. (vij_blones_jr@yahoo.com)
+See https://sourceforge.net/projects/yaglib/ for the latest updates.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, 
+      this list of conditions and the following disclaimer.
+      
+    * Redistributions in binary form must reproduce the above copyright notice, 
+      this list of conditions and the following disclaimer in the documentation 
+      and/or other materials provided with the distribution.
+      
+    * Neither the name of this library (YAGLib) nor the names of its contributors 
+      may be used to endorse or promote products derived from this software 
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/** 
+ * @file  GjCharConv.h
+ * @brief Number parsing and formatting without scanf/printf
+ *
+ * Modelled on C++17's from_chars/to_chars: they work on a range of 
+ * characters, narrow or wide, never allocate, never look at the locale,
+ * and say where they stopped and what went wrong.  Unlike the standard 
+ * ones, parsing skips leading whitespace and takes a leading '+', the
+ * way the scanf-based string_utils::parse_* functions always did.
+ *
+ * Doubles with up to 15 or so significant digits, which is everything in
+ * our config files, are converted with a single multiply or divide.  The
+ * rest are handed to strtod, rewritten without a decimal point so the
+ * locale doesn't matter.  Past 19 significant digits the extra ones are
+ * dropped.  Doubles are formatted in fixed notation like "%f", rounding 
+ * the same way.
+ *
+ */
+#ifndef GJ_CHAR_CONV_HEADER
+#define GJ_CHAR_CONV_HEADER
+
+#include <cstring>
+#include <cstdlib>
+#include <cfloat>
+#include <cmath>
+
+namespace yaglib
+{
+
+namespace string_utils
+{
+
+typedef enum CharConvError
+{
+  CHARCONV_OK = 0,
+  CHARCONV_INVALID,         // no number there
+  CHARCONV_OUT_OF_RANGE,    // a number, but it doesn't fit the type
+  CHARCONV_NO_ROOM          // the destination is too small
+} CharConvError;
+
+// ptr is one past the last character used, or written.  on errors the
+// value is left alone; ptr is the start of the range for parsing, and 
+// the end of it for formatting.
+template<class Pointer> struct CharConvResult
+{
+  Pointer ptr;
+  CharConvError error;
+
+  CharConvResult(Pointer p, const CharConvError e = CHARCONV_OK) : ptr(p), error(e) {};
+  bool ok() const { return error == CHARCONV_OK; };
+};
+
+namespace detail
+{
+
+typedef unsigned __int64 Magnitude;
+
+template<class CharType> inline bool is_blank(const CharType c)
+{
+  return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n') || (c == '\v') || (c == '\f');
+}
+
+// 36 for anything that isn't a digit in any base
+template<class CharType> inline int digit_value(const CharType c)
+{
+  if((c >= '0') && (c <= '9')) return c - '0';
+  if((c >= 'a') && (c <= 'z')) return c - 'a' + 10;
+  if((c >= 'A') && (c <= 'Z')) return c - 'A' + 10;
+  return 36;
+}
+
+template<class CharType> inline const CharType* skip_blanks(const CharType* first, const CharType* last)
+{
+  while((first != last) && is_blank(*first))
+    first++;
+  return first;
+}
+
+// matches a word, ignoring case
+template<class CharType> inline bool match_word(const CharType* first, const CharType* last, const char* word)
+{
+  for(; *word != 0; first++, word++)
+    if((first == last) || ((*first | 0x20) != *word))
+      return false;
+  return true;
+}
+
+// digits only, no sign.  digits past the limit are still taken, the
+// caller gets the out of range error and where the number ended.
+template<class CharType> inline CharConvResult<const CharType*> parse_magnitude(
+  const CharType* first, const CharType* last, Magnitude& value, const Magnitude limit, const int base)
+{
+  const CharType* p = first;
+  Magnitude result = 0;
+  bool overflow = false;
+  for(; p != last; p++)
+  {
+    int digit = digit_value(*p);
+    if(digit >= base)
+      break;
+    if(result > (limit - digit) / base)
+      overflow = true;
+    else
+      result = result * base + digit;
+  }
+
+  if(p == first)
+    return CharConvResult<const CharType*>(first, CHARCONV_INVALID);
+  if(overflow)
+    return CharConvResult<const CharType*>(p, CHARCONV_OUT_OF_RANGE);
+  value = result;
+  return CharConvResult<const CharType*>(p);
+}
+
+// digits of an unsigned value in reverse, returns the count
+template<class CharType> inline int reverse_digits(CharType* dest, Magnitude value, const int base)
+{
+  static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+  int count = 0;
+  do
+  {
+    dest[count++] = digits[value % base];
+    value /= base;
+  } while(value != 0);
+  return count;
+}
+
+template<class CharType> inline CharConvResult<CharType*> copy_reversed(
+  CharType* first, CharType* last, const CharType* digits, int count)
+{
+  if(last - first < count)
+    return CharConvResult<CharType*>(last, CHARCONV_NO_ROOM);
+  while(count > 0)
+    *first++ = digits[--count];
+  return CharConvResult<CharType*>(first);
+}
+
+template<class CharType> inline CharConvResult<CharType*> copy_text(
+  CharType* first, CharType* last, const char* text)
+{
+  size_t length = strlen(text);
+  if(static_cast<size_t>(last - first) < length)
+    return CharConvResult<CharType*>(last, CHARCONV_NO_ROOM);
+  while(*text != 0)
+    *first++ = *text++;
+  return CharConvResult<CharType*>(first);
+}
+
+// the powers of ten a double holds exactly
+inline double power_of_ten(const int exponent)
+{
+  static const double exact[] = { 
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+  return exact[exponent];
+}
+
+// mantissa * 10^exponent, correctly rounded.  both fit in a double
+// most of the time, and then one operation rounds it right.
+inline double scale_decimal(const Magnitude mantissa, const int exponent)
+{
+  if((mantissa <= (Magnitude(1) << 53)) && (exponent >= -22) && (exponent <= 22))
+  {
+    double result = static_cast<double>(mantissa);
+    return (exponent >= 0) ? result * power_of_ten(exponent) : result / power_of_ten(-exponent);
+  }
+
+  // "<digits>e<exponent>" reads the same in every locale
+  char text[40];
+  int count = 0;
+  char digits[24];
+  int digitCount = reverse_digits(digits, mantissa, 10);
+  while(digitCount > 0)
+    text[count++] = digits[--digitCount];
+  text[count++] = 'e';
+  if(exponent < 0)
+    text[count++] = '-';
+  digitCount = reverse_digits(digits, static_cast<Magnitude>(exponent < 0 ? -exponent : exponent), 10);
+  while(digitCount > 0)
+    text[count++] = digits[--digitCount];
+  text[count] = 0;
+  return strtod(text, NULL);
+}
+
+// Dekker's product, hi + lo is exactly a * b
+inline void exact_product(const double a, const double b, double& hi, double& lo)
+{
+  const double split = 134217729.0;
+  double ta = split * a, aHi = ta - (ta - a), aLo = a - aHi;
+  double tb = split * b, bHi = tb - (tb - b), bLo = b - bHi;
+  hi = a * b;
+  lo = ((aHi * bHi - hi) + aHi * bLo + aLo * bHi) + aLo * bLo;
+}
+
+// the integral part of a double too big for a Magnitude, it's exactly
+// mantissa * 2^shift.  worked out in base 10^9 limbs, least significant 
+// first; DBL_MAX needs 35 of them.
+template<class CharType> inline int reverse_big_digits(CharType* dest, const double value)
+{
+  unsigned int limbs[40];
+  int exponent;
+  Magnitude mantissa = static_cast<Magnitude>(ldexp(frexp(value, &exponent), 53));
+  int shift = exponent - 53;
+
+  int used = 0;
+  for(; mantissa != 0; mantissa /= 1000000000)
+    limbs[used++] = static_cast<unsigned int>(mantissa % 1000000000);
+  for(; shift > 0; shift--)
+  {
+    unsigned int carry = 0;
+    for(int i = 0; i < used; i++)
+    {
+      unsigned int limb = limbs[i] * 2 + carry;
+      carry = (limb >= 1000000000) ? 1 : 0;
+      limbs[i] = limb - carry * 1000000000;
+    }
+    if(carry != 0)
+      limbs[used++] = carry;
+  }
+
+  int count = 0;
+  for(int i = 0; i < used; i++)
+  {
+    unsigned int limb = limbs[i];
+    for(int j = 0; (j < 9) && ((i < used - 1) || (limb != 0)); j++)
+    {
+      dest[count++] = static_cast<CharType>('0' + limb % 10);
+      limb /= 10;
+    }
+  }
+  return count;
+}
+
+} /* namespace detail */
+
+// integers, in any base from 2 to 36
+template<class CharType> CharConvResult<const CharType*> from_chars(
+  const CharType* first, const CharType* last, int& value, const int base = 10)
+{
+  const CharType* p = detail::skip_blanks(first, last);
+  bool negative = (p != last) && (*p == '-');
+  if((p != last) && ((*p == '-') || (*p == '+')))
+    p++;
+
+  detail::Magnitude magnitude;
+  detail::Magnitude limit = negative ? detail::Magnitude(2147483647) + 1 : 2147483647;
+  CharConvResult<const CharType*> result = detail::parse_magnitude(p, last, magnitude, limit, base);
+  if(result.error == CHARCONV_INVALID)
+    return CharConvResult<const CharType*>(first, CHARCONV_INVALID);
+  if(result.ok())
+    value = negative ? static_cast<int>(0 - static_cast<unsigned int>(magnitude)) : static_cast<int>(magnitude);
+  return result;
+}
+
+template<class CharType> CharConvResult<const CharType*> from_chars(
+  const CharType* first, const CharType* last, unsigned int& value, const int base = 10)
+{
+  const CharType* p = detail::skip_blanks(first, last);
+  if((p != last) && (*p == '+'))
+    p++;
+
+  detail::Magnitude magnitude;
+  CharConvResult<const CharType*> result = detail::parse_magnitude(p, last, magnitude, 0xFFFFFFFF, base);
+  if(result.error == CHARCONV_INVALID)
+    return CharConvResult<const CharType*>(first, CHARCONV_INVALID);
+  if(result.ok())
+    value = static_cast<unsigned int>(magnitude);
+  return result;
+}
+
+// decimal, with an optional exponent, "inf", "infinity" or "nan"
+template<class CharType> CharConvResult<const CharType*> from_chars(
+  const CharType* first, const CharType* last, double& value)
+{
+  const CharType* p = detail::skip_blanks(first, last);
+  bool negative = (p != last) && (*p == '-');
+  if((p != last) && ((*p == '-') || (*p == '+')))
+    p++;
+
+  if(detail::match_word(p, last, "inf"))
+  {
+    p += detail::match_word(p, last, "infinity") ? 8 : 3;
+    value = negative ? -HUGE_VAL : HUGE_VAL;
+    return CharConvResult<const CharType*>(p);
+  }
+  if(detail::match_word(p, last, "nan"))
+  {
+    double zero = 0.0;
+    value = zero / zero;
+    return CharConvResult<const CharType*>(p + 3);
+  }
+
+  // up to 19 significant digits are kept, the rest only move the exponent
+  detail::Magnitude mantissa = 0;
+  int significant = 0, exponent = 0;
+  bool anyDigits = false;
+  for(; (p != last) && (*p >= '0') && (*p <= '9'); p++)
+  {
+    anyDigits = true;
+    if(significant < 19)
+    {
+      mantissa = mantissa * 10 + (*p - '0');
+      significant += (mantissa != 0) ? 1 : 0;
+    }
+    else
+      exponent++;
+  }
+  if((p != last) && (*p == '.'))
+    for(p++; (p != last) && (*p >= '0') && (*p <= '9'); p++)
+    {
+      anyDigits = true;
+      if(significant < 19)
+      {
+        mantissa = mantissa * 10 + (*p - '0');
+        significant += (mantissa != 0) ? 1 : 0;
+        exponent--;
+      }
+    }
+  if(!anyDigits)
+    return CharConvResult<const CharType*>(first, CHARCONV_INVALID);
+
+  // an 'e' without digits after it isn't part of the number
+  if((p != last) && ((*p == 'e') || (*p == 'E')))
+  {
+    const CharType* q = p + 1;
+    bool negativeExponent = (q != last) && (*q == '-');
+    if((q != last) && ((*q == '-') || (*q == '+')))
+      q++;
+    if((q != last) && (*q >= '0') && (*q <= '9'))
+    {
+      int written = 0;
+      for(; (q != last) && (*q >= '0') && (*q <= '9'); q++)
+        if(written < 100000)
+          written = written * 10 + (*q - '0');
+      exponent += negativeExponent ? -written : written;
+      p = q;
+    }
+  }
+
+  // 19 digits at most, past these it's 0 or infinity anyway
+  exponent = (exponent > 400) ? 400 : ((exponent < -400) ? -400 : exponent);
+  double result = (mantissa != 0) ? detail::scale_decimal(mantissa, exponent) : 0.0;
+  if((result > DBL_MAX) || ((result == 0.0) && (mantissa != 0)))
+    return CharConvResult<const CharType*>(p, CHARCONV_OUT_OF_RANGE);
+
+  value = negative ? -result : result;
+  return CharConvResult<const CharType*>(p);
+}
+
+template<class CharType> CharConvResult<CharType*> to_chars(
+  CharType* first, CharType* last, const int value, const int base = 10)
+{
+  CharType digits[40];
+  unsigned int magnitude = static_cast<unsigned int>(value);
+  if(value < 0)
+  {
+    if(first == last)
+      return CharConvResult<CharType*>(last, CHARCONV_NO_ROOM);
+    magnitude = 0 - magnitude;
+    *first++ = '-';
+  }
+  return detail::copy_reversed(first, last, digits, detail::reverse_digits(digits, magnitude, base));
+}
+
+template<class CharType> CharConvResult<CharType*> to_chars(
+  CharType* first, CharType* last, const unsigned int value, const int base = 10)
+{
+  CharType digits[40];
+  return detail::copy_reversed(first, last, digits, detail::reverse_digits(digits, value, base));
+}
+
+// fixed notation, like "%.*f"
+template<class CharType> CharConvResult<CharType*> to_chars(
+  CharType* first, CharType* last, double value, int precision = 6)
+{
+  if(value != value)
+    return detail::copy_text(first, last, "nan");
+
+  if((value < 0) || ((value == 0) && (1 / value < 0)))
+  {
+    if(first == last)
+      return CharConvResult<CharType*>(last, CHARCONV_NO_ROOM);
+    *first++ = '-';
+    value = -value;
+  }
+  if(value > DBL_MAX)
+  {
+    CharConvResult<CharType*> result = detail::copy_text(first, last, "inf");
+    return result.ok() ? result : CharConvResult<CharType*>(last, CHARCONV_NO_ROOM);
+  }
+
+  precision = (precision < 0) ? 0 : ((precision > 17) ? 17 : precision);
+  detail::Magnitude scale = 1;
+  for(int i = 0; i < precision; i++)
+    scale *= 10;
+
+  // under 2^53 the integral part and the fraction are both exact
+  CharType digits[320];
+  int count;
+  detail::Magnitude fraction = 0;
+  if(value < 9007199254740992.0)
+  {
+    double integral = floor(value);
+    detail::Magnitude whole = static_cast<detail::Magnitude>(integral);
+
+    // scaled exactly, so halfway cases round to even as printf does
+    double hi, lo;
+    detail::exact_product(value - integral, static_cast<double>(scale), hi, lo);
+    double truncated = floor(hi);
+    double rest = (hi - truncated) + lo;
+    if(rest < 0)
+    {
+      truncated -= 1;
+      rest += 1;
+    }
+    fraction = static_cast<detail::Magnitude>(truncated);
+    detail::Magnitude lastDigit = (precision > 0) ? fraction : whole;
+    if((rest > 0.5) || ((rest == 0.5) && ((lastDigit & 1) != 0)))
+      fraction++;
+    if(fraction >= scale)
+    {
+      whole++;
+      fraction -= scale;
+    }
+    count = detail::reverse_digits(digits, whole, 10);
+  }
+  else
+    count = detail::reverse_big_digits(digits, value);
+
+  if(last - first < count + ((precision > 0) ? precision + 1 : 0))
+    return CharConvResult<CharType*>(last, CHARCONV_NO_ROOM);
+  first = detail::copy_reversed(first, last, digits, count).ptr;
+  if(precision > 0)
+  {
+    *first++ = '.';
+    for(int i = precision - 1; i >= 0; i--)
+    {
+      first[i] = static_cast<CharType>('0' + fraction % 10);
+      fraction /= 10;
+    }
+    first += precision;
+  }
+  return CharConvResult<CharType*>(first);
+}
+
+} /* namespace string_utils */
+
+} /* namespace yaglib */
+
+#endif /* GJ_CHAR_CONV_HEADER */
@@ -36,38 +36,347 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "GjStringUtils.h"
 #include "GjBFS.h"
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
 #include <fstream>
 using namespace yaglib;
 
-void IniSettingsStore::load(const WideString& objectName, MultipleSettings& settings)
+// IniParser
+static inline bool isBlank(const char c)
 {
-  if(!bfs::exists(objectName) || bfs::is_directory(objectName))
-    return;
+  return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n') || (c == '\v') || (c == '\f');
+}
+
+static inline IniParser::Span trimmed(const char* begin, const char* end)
+{
+  while((begin < end) && isBlank(*begin))
+    begin++;
+  while((end > begin) && isBlank(*(end - 1)))
+    end--;
+
+  IniParser::Span result = { begin, static_cast<size_t>(end - begin) };
+  return result;
+}
 
-  std::ifstream source(UTF8String(objectName).c_str());
-  std::string ss;
-  Settings* group = NULL;
-  while(getline(source, ss))
+IniParser::IniParser(const char* text, const size_t size)
+{
+  parse(text, size);
+}
+
+void IniParser::parse(const char* text, const size_t size)
+{
+  const char* end = text + size;
+  for(const char* line = text; line < end; )
   {
-    // remove whitespaces, skip blanks and comments
-    boost::trim(ss);
-    if((ss.size() == 0) || (ss[0] == COMMENT_CHAR))
+    const char* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+    if(lineEnd == NULL)
+      lineEnd = end;
+
+    // skip blanks and comments
+    Span ss = trimmed(line, lineEnd);
+    line = lineEnd + 1;
+    if((ss.length == 0) || (ss.text[0] == COMMENT_CHAR))
       continue;
-    
-    // check for section starts
-    if(ss[0] == SECTION_BEGIN_CHAR)
+
+    const char* ssEnd = ss.text + ss.length;
+    if(ss.text[0] == SECTION_BEGIN_CHAR)
     {
-      WideString ws = from_char_p(std::string(ss.substr(1, ss.find(SECTION_END_CHAR) - 1)).c_str());
-      group = &(settings[ws]);
+      const char* close = static_cast<const char*>(memchr(ss.text, SECTION_END_CHAR, ss.length));
+      Section section;
+      section.name.text = ss.text + 1;
+      section.name.length = ((close != NULL) ? close : ssEnd) - section.name.text;
+      section.firstEntry = static_cast<int>(mEntries.size());
+      section.entryCount = 0;
+      mSections.push_back(section);
       continue;
     }
 
-    // an item! add to the group if there's one
-    if(NULL != group)
-      group->add(from_char_p(ss.c_str()));
+    if(mSections.empty())
+      continue;
+
+    // name=value, both trimmed
+    const char* equals = static_cast<const char*>(memchr(ss.text, '=', ss.length));
+    Entry entry;
+    entry.name = trimmed(ss.text, (equals != NULL) ? equals : ssEnd);
+    entry.value = (equals != NULL) ? trimmed(equals + 1, ssEnd) : trimmed(ssEnd, ssEnd);
+    mEntries.push_back(entry);
+    mSections.back().entryCount++;
   }
 }
 
+int IniParser::getSectionCount() const
+{
+  return static_cast<int>(mSections.size());
+}
+
+IniParser::Section const& IniParser::getSection(const int index) const
+{
+  return mSections[index];
+}
+
+IniParser::Entry const& IniParser::getEntry(const int index) const
+{
+  return mEntries[index];
+}
+
+void IniParser::fill(MultipleSettings& settings) const
+{
+  for(std::vector<Section>::const_iterator iter = mSections.begin(); iter != mSections.end(); iter++)
+  {
+    Settings& group = settings[widen(iter->name)];
+    group.reserve(iter->entryCount);
+    for(int i = iter->firstEntry; i < iter->firstEntry + iter->entryCount; i++)
+      group.add(widen(mEntries[i].name), widen(mEntries[i].value));
+  }
+}
+
+WideString IniParser::widen(const Span& span)
+{
+  // plain ASCII, by far the usual, just widens. anything else is decoded.
+  WideString result(span.length, 0);
+  for(size_t i = 0; i < span.length; i++)
+  {
+    unsigned char c = static_cast<unsigned char>(span.text[i]);
+    if(c >= 0x80)
+      return UTF8String(std::string(span.text, span.length).c_str()).asWideString();
+    result[i] = static_cast<WideChar>(c);
+  }
+  return result;
+}
+
+// IniSnapshot
+static const int SNAPSHOT_SIGNATURE = 0x50534E59;   // "YNSP"
+static const int SNAPSHOT_VERSION = 1;
+
+struct SnapshotHeader
+{
+  int signature;
+  int version;
+  LONGLONG sourceSize;
+  LONGLONG sourceTime;    // last write, as a FILETIME
+  int sectionCount;
+  int entryCount;
+  int poolLength;         // in characters
+};
+
+struct SnapshotSection
+{
+  int nameOffset;
+  int nameLength;
+  int entryCount;
+};
+
+struct SnapshotEntry
+{
+  int nameOffset;
+  int nameLength;
+  int valueOffset;
+  int valueLength;
+};
+
+// empty while snapshots are off
+static WideString snapshotFolder;
+
+void IniSnapshot::setFolder(const WideString& folder)
+{
+  snapshotFolder = folder.empty() ? folder : string_utils::conditional_append_copy(folder, '\\');
+}
+
+WideString const& IniSnapshot::getFolder()
+{
+  return snapshotFolder;
+}
+
+// all of them in one folder, so the path goes into the name
+static WideString snapshotOf(const WideString& fileName)
+{
+  WideString name = fileName;
+  std::replace(name.begin(), name.end(), L'\\', L'_');
+  std::replace(name.begin(), name.end(), L'/', L'_');
+  std::replace(name.begin(), name.end(), L':', L'_');
+  return snapshotFolder + name + INI_SNAPSHOT_EXTENSION;
+}
+
+// whatever size the file happens to be
+static const size_t ANY_SIZE = static_cast<size_t>(-1);
+
+static bool stampOf(const WideString& fileName, const size_t expected, LONGLONG& size, LONGLONG& time)
+{
+  WIN32_FILE_ATTRIBUTE_DATA data;
+  if(!GetFileAttributesEx(fileName.c_str(), GetFileExInfoStandard, &data))
+    return false;
+
+  size = (static_cast<LONGLONG>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+  time = (static_cast<LONGLONG>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+  return (expected == ANY_SIZE) || (size == static_cast<LONGLONG>(expected));
+}
+
+bool IniSnapshot::load(const WideString& fileName, MultipleSettings& settings)
+{
+  return load(fileName, ANY_SIZE, settings);
+}
+
+bool IniSnapshot::save(const WideString& fileName, const IniParser& parser)
+{
+  return save(fileName, ANY_SIZE, parser);
+}
+
+bool IniSnapshot::load(const WideString& fileName, const size_t textSize, MultipleSettings& settings)
+{
+  LONGLONG sourceSize, sourceTime;
+  if(snapshotFolder.empty() || !stampOf(fileName, textSize, sourceSize, sourceTime))
+    return false;
+
+  std::ifstream source(UTF8String(snapshotOf(fileName)).c_str(), std::ios::binary);
+  if(!source.good())
+    return false;
+  source.seekg(0, std::ios_base::end);
+  size_t size = source.tellg();
+  source.seekg(0, std::ios_base::beg);
+  if(size < sizeof(SnapshotHeader))
+    return false;
+
+  std::vector<char> data(size);
+  source.read(&data[0], static_cast<std::streamsize>(size));
+  if(!source.good())
+    return false;
+
+  // stale, or not all there, and it's as good as not being there at all
+  const SnapshotHeader* header = reinterpret_cast<const SnapshotHeader*>(&data[0]);
+  if((header->signature != SNAPSHOT_SIGNATURE) || (header->version != SNAPSHOT_VERSION) ||
+     (header->sourceSize != sourceSize) || (header->sourceTime != sourceTime) ||
+     (header->sectionCount < 0) || (header->entryCount < 0) || (header->poolLength < 0))
+    return false;
+
+  size_t expected = sizeof(SnapshotHeader) + header->sectionCount * sizeof(SnapshotSection) +
+    header->entryCount * sizeof(SnapshotEntry) + header->poolLength * sizeof(WideChar);
+  if(size != expected)
+    return false;
+
+  const SnapshotSection* sections = reinterpret_cast<const SnapshotSection*>(&data[sizeof(SnapshotHeader)]);
+  const SnapshotEntry* entries = reinterpret_cast<const SnapshotEntry*>(sections + header->sectionCount);
+  const WideChar* pool = reinterpret_cast<const WideChar*>(entries + header->entryCount);
+
+  // check it all before anything is added
+  int total = 0;
+  for(int i = 0; i < header->sectionCount; i++)
+  {
+    const SnapshotSection& section = sections[i];
+    if((section.nameOffset < 0) || (section.nameLength < 0) || (section.entryCount < 0) ||
+       (section.nameLength > header->poolLength - section.nameOffset))
+      return false;
+    total += section.entryCount;
+  }
+  if(total != header->entryCount)
+    return false;
+  for(int i = 0; i < header->entryCount; i++)
+  {
+    const SnapshotEntry& entry = entries[i];
+    if((entry.nameOffset < 0) || (entry.nameLength < 0) || (entry.valueOffset < 0) || (entry.valueLength < 0) ||
+       (entry.nameLength > header->poolLength - entry.nameOffset) ||
+       (entry.valueLength > header->poolLength - entry.valueOffset))
+      return false;
+  }
+
+  // the same adds the parser's fill() would have made
+  const SnapshotEntry* entry = entries;
+  for(int i = 0; i < header->sectionCount; i++)
+  {
+    Settings& group = settings[WideString(pool + sections[i].nameOffset, sections[i].nameLength)];
+    group.reserve(sections[i].entryCount);
+    for(int j = 0; j < sections[i].entryCount; j++, entry++)
+      group.add(WideString(pool + entry->nameOffset, entry->nameLength), 
+        WideString(pool + entry->valueOffset, entry->valueLength));
+  }
+
+  return true;
+}
+
+bool IniSnapshot::save(const WideString& fileName, const size_t textSize, const IniParser& parser)
+{
+  SnapshotHeader header;
+  header.signature = SNAPSHOT_SIGNATURE;
+  header.version = SNAPSHOT_VERSION;
+  if(snapshotFolder.empty() || !stampOf(fileName, textSize, header.sourceSize, header.sourceTime))
+    return false;
+
+  std::vector<SnapshotSection> sections;
+  std::vector<SnapshotEntry> entries;
+  WideString pool;
+  for(int i = 0; i < parser.getSectionCount(); i++)
+  {
+    IniParser::Section const& source = parser.getSection(i);
+    WideString name = IniParser::widen(source.name);
+    SnapshotSection section = { static_cast<int>(pool.size()), static_cast<int>(name.size()), source.entryCount };
+    pool += name;
+    sections.push_back(section);
+
+    for(int j = source.firstEntry; j < source.firstEntry + source.entryCount; j++)
+    {
+      WideString entryName = IniParser::widen(parser.getEntry(j).name);
+      WideString entryValue = IniParser::widen(parser.getEntry(j).value);
+      SnapshotEntry entry;
+      entry.nameOffset = static_cast<int>(pool.size());
+      entry.nameLength = static_cast<int>(entryName.size());
+      pool += entryName;
+      entry.valueOffset = static_cast<int>(pool.size());
+      entry.valueLength = static_cast<int>(entryValue.size());
+      pool += entryValue;
+      entries.push_back(entry);
+    }
+  }
+
+  header.sectionCount = static_cast<int>(sections.size());
+  header.entryCount = static_cast<int>(entries.size());
+  header.poolLength = static_cast<int>(pool.size());
+
+  // the folder is ours, make it if it isn't there yet
+  if(!bfs::exists(snapshotFolder))
+    CreateDirectory(snapshotFolder.c_str(), NULL);
+  std::ofstream dest(UTF8String(snapshotOf(fileName)).c_str(), std::ios::binary | std::ios::trunc);
+  if(!dest.good())
+    return false;
+
+  dest.write(reinterpret_cast<const char*>(&header), sizeof(SnapshotHeader));
+  if(!sections.empty())
+    dest.write(reinterpret_cast<const char*>(&sections[0]), sections.size() * sizeof(SnapshotSection));
+  if(!entries.empty())
+    dest.write(reinterpret_cast<const char*>(&entries[0]), entries.size() * sizeof(SnapshotEntry));
+  if(!pool.empty())
+    dest.write(reinterpret_cast<const char*>(pool.c_str()), pool.size() * sizeof(WideChar));
+  return dest.good();
+}
+
+// IniSettingsStore
+IniSettingsStore::IniSettingsStore(const bool useSnapshots) : mUseSnapshots(useSnapshots)
+{
+}
+
+void IniSettingsStore::load(const WideString& objectName, MultipleSettings& settings)
+{
+  if(!bfs::exists(objectName) || bfs::is_directory(objectName))
+    return;
+
+  if(mUseSnapshots && IniSnapshot::load(objectName, settings))
+    return;
+
+  // all of it in one read, then parsed in place
+  std::ifstream source(UTF8String(objectName).c_str(), std::ios::binary);
+  source.seekg(0, std::ios_base::end);
+  size_t size = source.tellg();
+  source.seekg(0, std::ios_base::beg);
+  if(size == 0)
+    return;
+
+  std::vector<char> text(size);
+  source.read(&text[0], static_cast<std::streamsize>(size));
+  IniParser parser(&text[0], static_cast<size_t>(source.gcount()));
+  parser.fill(settings);
+
+  // the next load won't have to parse it. it's fine if it can't be written.
+  if(mUseSnapshots)
+    IniSnapshot::save(objectName, parser);
+}
+
 void IniSettingsStore::save(const WideString& objectName, MultipleSettings& settings)
 {
   if(bfs::exists(objectName))
@@ -76,11 +385,11 @@ void IniSettingsStore::save(const WideString& objectName, MultipleSettings& sett
   std::ofstream dest(UTF8String(objectName).c_str());
   for(int i = 0; i < static_cast<int>(settings.size()); i++)
   {
-    Settings group = settings[i];
+    Settings const& group = settings[i];
     dest << SECTION_BEGIN_CHAR << UTF8String(group.getName()).c_str() << SECTION_END_CHAR << std::endl;
     for(int j = 0; j < static_cast<int>(group.size()); j++)
     {
-      Setting item = group[j];
+      Setting const& item = group[j];
       dest << UTF8String(item.getName()).c_str() << '=' << UTF8String(item.getValue()).c_str() << std::endl;
     }
   }
@@ -92,12 +401,39 @@ IniSettings::IniSettings(const WideString& fileName)
   load(fileName);
 }
 
+IniSettings::IniSettings(const char* text, const size_t size)
+{
+  load(text, size);
+}
+
+IniSettings::IniSettings(const char* text, const size_t size, const WideString& fileName)
+{
+  load(text, size, fileName);
+}
+
 void IniSettings::load(const WideString& fileName)
 {
   IniSettingsStore iss;
   iss.load(fileName, *this);
 }
 
+void IniSettings::load(const char* text, const size_t size)
+{
+  IniParser(text, size).fill(*this);
+}
+
+void IniSettings::load(const char* text, const size_t size, const WideString& fileName)
+{
+  // text that isn't a file of its own (out of an archive, say) has no
+  // stamp to check a snapshot against, and is just parsed
+  if(IniSnapshot::load(fileName, size, *this))
+    return;
+
+  IniParser parser(text, size);
+  parser.fill(*this);
+  IniSnapshot::save(fileName, size, parser);
+}
+
 void IniSettings::save(const WideString& fileName)
 {
   IniSettingsStore iss;
@@ -50,18 +50,108 @@ namespace yaglib
 #define SECTION_BEGIN_CHAR  '['
 #define SECTION_END_CHAR    ']' 
 
+/* tokenizes .ini text (UTF-8) sitting in memory: a mapped file, a data
+   pack, an archive blob.  it's done in one pass, and nothing is copied; 
+   sections and entries are kept as spans of the text, and only turned 
+   into wide strings when asked for.  the text must outlive the parser.
+   entries before the first section are ignored. */
+class IniParser
+{
+public:
+  struct Span
+  {
+    const char* text;
+    size_t length;
+  };
+
+  struct Entry
+  {
+    Span name;
+    Span value;   // empty if there was no '='
+  };
+
+  struct Section
+  {
+    Span name;
+    int firstEntry;
+    int entryCount;
+  };
+
+  IniParser(const char* text, const size_t size);
+
+  int getSectionCount() const;
+  Section const& getSection(const int index) const;
+  Entry const& getEntry(const int index) const;
+
+  // adds what was parsed to the settings, merging sections by name
+  void fill(MultipleSettings& settings) const;
+
+  static WideString widen(const Span& span);
+
+private:
+  std::vector<Section> mSections;
+  std::vector<Entry> mEntries;
+
+  void parse(const char* text, const size_t size);
+};
+
+// what a file's snapshot is called: the file's name, with the path
+// separators flattened, and this added
+#define INI_SNAPSHOT_EXTENSION    L".snapshot"
+
+// where the framework looks for the snapshot folder, relative to the
+// application's folder. there are no snapshots unless it's set.
+#define CONFIG_SNAPSHOT_SECTION   L"ini-snapshots"
+#define CONFIG_SNAPSHOT_FOLDER    L"folder"
+
+/* the compiled form of an .ini file: what the parser found, already in
+   wide strings, stamped with the size and write time of the file.  it 
+   loads in a single read with nothing to parse, and is only used while
+   the stamp still matches the file.  snapshots are off until setFolder()
+   names a folder to keep them in, at startup, before anything is loaded
+   on other threads.  keep it out of the resource folders, or the stores
+   will index the snapshots along with the rest. */
+class IniSnapshot
+{
+public:
+  static void setFolder(const WideString& folder);
+  static WideString const& getFolder();
+
+  // false, and nothing added, if snapshots are off, or there's no
+  // snapshot of the file, or it's stale
+  static bool load(const WideString& fileName, MultipleSettings& settings);
+  static bool save(const WideString& fileName, const IniParser& parser);
+  // the same, for text that was read from fileName some other way, a
+  // data pack say. the file has to be textSize bytes, or it's not the text.
+  static bool load(const WideString& fileName, const size_t textSize, MultipleSettings& settings);
+  static bool save(const WideString& fileName, const size_t textSize, const IniParser& parser);
+};
+
+/* with snapshots on, files are loaded from their snapshot when it's
+   fresh, and a snapshot is written whenever one is parsed.  nothing
+   happens either way until IniSnapshot::setFolder() has been called. */
 class IniSettingsStore : public SettingsStore
 {
 public:
+  IniSettingsStore(const bool useSnapshots = true);
+
   virtual void load(const WideString& objectName, MultipleSettings& settings);
   virtual void save(const WideString& objectName, MultipleSettings& settings);
+
+private:
+  bool mUseSnapshots;
 };
 
 class IniSettings : public MultipleSettings
 {
 public:
   IniSettings(const WideString& fileName);
+  IniSettings(const char* text, const size_t size);
+  // text read from fileName, which goes through its snapshot, if any
+  IniSettings(const char* text, const size_t size, const WideString& fileName);
   void load(const WideString& fileName);
+  void load(const char* text, const size_t size);
+  void load(const char* text, const size_t size, const WideString& fileName);
   void save(const WideString& fileName);
 };
 
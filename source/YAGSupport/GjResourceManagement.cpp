@@ -36,15 +36,96 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "GjNativeApp.h"
 #include "GjStringUtils.h"
 #include "GjBFS.h"
+#include "GjResourceManifest.h"
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <cwctype>
+#include <boost/bind.hpp>
 using namespace yaglib;
 
+struct HeapBlock
+{
+  void operator()(void* data) const { delete [] static_cast<char*>(data); };
+};
+
+struct MappedView
+{
+  void operator()(void* data) const { UnmapViewOfFile(data); };
+};
+
+// the whole file mapped for reading, or an empty buffer if it can't be
+static DataPack::Buffer mapFile(const WideString& fileName, size_t& size)
+{
+  DataPack::Buffer result;
+  HANDLE file = CreateFile(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, 
+    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if(file == INVALID_HANDLE_VALUE)
+    return result;
+
+  // empty files can't be mapped
+  LARGE_INTEGER fileSize;
+  if(GetFileSizeEx(file, &fileSize) && (fileSize.QuadPart > 0) && (fileSize.HighPart == 0))
+  {
+    HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mapping != NULL)
+    {
+      // the view keeps the file open, the handles aren't needed past this
+      void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      if(view != NULL)
+      {
+        result = DataPack::Buffer(view, MappedView());
+        size = static_cast<size_t>(fileSize.QuadPart);
+      }
+      CloseHandle(mapping);
+    }
+  }
+  CloseHandle(file);
+  return result;
+}
+
+void* DataPack::allocate(const size_t size)
+{
+  setData(Buffer(new char[size], HeapBlock()), size);
+  return mData;
+}
+
 // resource store base
 ResourceStore::ResourceStore(const WideString& pathName) : mPathName(pathName)
 {
 }
 
+ResourceStore::~ResourceStore()
+{
+}
+
+void ResourceStore::refresh()
+{
+}
+
+void ResourceStore::setWatching(const bool watching)
+{
+}
+
+bool ResourceStore::hasDiskPaths() const
+{
+  return true;
+}
+
+void ResourceStore::update()
+{
+}
+
+bool ResourceStore::listFiles(StoreListing& listing)
+{
+  return false;
+}
+
+ResourceCounters& ResourceStore::getCounters()
+{
+  return mCounters;
+}
+
 WideString const& ResourceStore::getPathName() const
 {
   return mPathName;
@@ -53,19 +134,28 @@ WideString const& ResourceStore::getPathName() const
 class FindFile : public std::unary_function<ResourceStore*, bool>
 {
 public:
-  explicit FindFile(DataPack& dataPack, const WideString& fileName, const bool fileNameOnly) : 
-    mDataPack(dataPack), mFileName(fileName), mFileNameOnly(fileNameOnly)
+  explicit FindFile(DataPack& dataPack, const WideString& fileName, const bool fileNameOnly, 
+    const bool diskPathsOnly) : 
+    mDataPack(dataPack), mFileName(fileName), mFileNameOnly(fileNameOnly), mDiskPathsOnly(diskPathsOnly)
   { };
   bool operator()(ResourceStore* store) 
-  { return store->lookup(mDataPack, mFileName, mFileNameOnly); };
+  { 
+    if(mDiskPathsOnly && !store->hasDiskPaths())
+      return false;
+    LONGLONG start = ResourceCounters::now();
+    bool found = store->lookup(mDataPack, mFileName, mFileNameOnly);
+    store->getCounters().record(found, mDataPack.getSize(), ResourceCounters::now() - start);
+    return found;
+  };
 private:
   DataPack& mDataPack;
   WideString mFileName;
   bool mFileNameOnly;
+  bool mDiskPathsOnly;
 };
 
-FileSystemStore::FileSystemStore(const WideString& pathName) : 
-  ResourceStore(pathName), mQualifiedPath(pathName)
+FileSystemStore::FileSystemStore(const WideString& pathName, const StoreListing* listing) : 
+  ResourceStore(pathName), mQualifiedPath(pathName), mChanges(INVALID_HANDLE_VALUE)
 {
   WideString::iterator iter = mQualifiedPath.end()-1;
   if((*iter) != '\\') 
@@ -73,70 +163,527 @@ FileSystemStore::FileSystemStore(const WideString& pathName) :
     
   if(!bfs::exists(mQualifiedPath) || !bfs::is_directory(mQualifiedPath))
     throw std::exception("Resource folder does not exists");
+
+  if((listing != NULL) && isCurrent(*listing))
+    index(listing->files);
+  else
+    reindex();
+}
+
+FileSystemStore::~FileSystemStore()
+{
+  setWatching(false);
+}
+
+void FileSystemStore::collectFiles(const WideString& relativePath, StoreListing& listing, const bool stamped)
+{
+  // the stamp is taken before the folder is read, a change made while
+  // it's being read has it scanned again the next time
+  listing.folders.push_back(relativePath);
+  if(stamped)
+    listing.stamps.push_back(bfs::last_write_time(mQualifiedPath + relativePath));
+
+  std::vector<WideString> names;
+  bfs::list_files(mQualifiedPath + relativePath, names, true, false);
+  for(std::vector<WideString>::iterator iter = names.begin(); iter != names.end(); iter++)
+  {
+    listing.files.push_back(relativePath + *iter);
+    if(stamped)
+      listing.sizes.push_back(bfs::file_size(mQualifiedPath + relativePath + *iter));
+  }
+
+  names.clear();
+  bfs::list_files(mQualifiedPath + relativePath, names, false, true);
+  for(std::vector<WideString>::iterator iter = names.begin(); iter != names.end(); iter++)
+    collectFiles(relativePath + *iter + L"\\", listing, stamped);
+}
+
+bool FileSystemStore::isCurrent(const StoreListing& listing)
+{
+  // adding, removing or renaming a file or a folder writes the folder
+  // it's in, a new folder shows up in its parent's stamp
+  if(listing.folders.empty() || (listing.folders.size() != listing.stamps.size()))
+    return false;
+
+  for(size_t i = 0; i < listing.folders.size(); i++)
+    if(bfs::last_write_time(mQualifiedPath + listing.folders[i]) != listing.stamps[i])
+      return false;
+
+  return true;
+}
+
+void FileSystemStore::index(const std::vector<WideString>& files)
+{
+  mIndex.clear();
+  mIndex.reserve(files.size());
+  for(std::vector<WideString>::const_iterator iter = files.begin(); iter != files.end(); iter++)
+    mIndex.insert(*iter, 0);
+}
+
+void FileSystemStore::reindex()
+{
+  StoreListing listing;
+  collectFiles(L"", listing, false);
+  index(listing.files);
+}
+
+void FileSystemStore::refresh()
+{
+  ScopedLock lock(mLock);
+  reindex();
+}
+
+bool FileSystemStore::listFiles(StoreListing& listing)
+{
+  // straight from the disk, the index may be out of date
+  collectFiles(L"", listing, true);
+  return true;
+}
+
+void FileSystemStore::setWatching(const bool watching)
+{
+  ScopedLock lock(mLock);
+  if(watching && (mChanges == INVALID_HANDLE_VALUE))
+    mChanges = FindFirstChangeNotification(mQualifiedPath.c_str(), TRUE,
+      FILE_NOTIFY_CHANGE_FILE_NAME|FILE_NOTIFY_CHANGE_DIR_NAME);
+  else if(!watching && (mChanges != INVALID_HANDLE_VALUE))
+  {
+    FindCloseChangeNotification(mChanges);
+    mChanges = INVALID_HANDLE_VALUE;
+  }
+}
+
+void FileSystemStore::checkChanges()
+{
+  // anything added, removed or renamed since the last time has the
+  // whole tree indexed again. it's for development, that will do.
+  if((mChanges == INVALID_HANDLE_VALUE) || (WaitForSingleObject(mChanges, 0) != WAIT_OBJECT_0))
+    return;
+
+  FindNextChangeNotification(mChanges);
+  reindex();
 }
 
 bool FileSystemStore::lookup(DataPack& dataPack, const WideString fileName, const bool fileNameOnly)
 {
+  {
+    ScopedLock lock(mLock);
+    checkChanges();
+    if(mIndex.find(fileName) == StringIndex<NoCasePathChars>::npos)
+      return false;
+  }
+
   WideString qualifiedFileName = mQualifiedPath + fileName;
-  if(!bfs::exists(qualifiedFileName) || bfs::is_directory(qualifiedFileName))
-    return false;
 
   dataPack.setFileName(qualifiedFileName);
   if(!fileNameOnly)
   {
-    std::ifstream source(UTF8String(qualifiedFileName).c_str(), std::ios::binary);
-    source.seekg(0, std::ios_base::end);
-    size_t size = source.tellg();
-    source.seekg(0, std::ios_base::beg);
+    // mapped when possible, the pages are only read in as they're used
+    size_t size = 0;
+    DataPack::Buffer mapped = mapFile(qualifiedFileName, size);
+    if(mapped)
+      dataPack.setData(mapped, size);
+    else
+    {
+      // the index may still list a file that has since been deleted,
+      // or it may be locked. either way it's a miss.
+      std::ifstream source(UTF8String(qualifiedFileName).c_str(), std::ios::binary);
+      source.seekg(0, std::ios_base::end);
+      std::streamoff end = source.tellg();
+      source.seekg(0, std::ios_base::beg);
+      if(!source.good() || (end < 0))
+      {
+        dataPack.setFileName(L"");
+        return false;
+      }
 
-    char* data = new char[size];
-    source.read(data, static_cast<std::streamsize>(size));
-    dataPack.setData(data, size);
+      size = static_cast<size_t>(end);
+      char* data = static_cast<char*>(dataPack.allocate(size));
+      source.read(data, static_cast<std::streamsize>(size));
+      if(static_cast<size_t>(source.gcount()) != size)
+      {
+        dataPack.cleanup();
+        dataPack.setFileName(L"");
+        return false;
+      }
+    }
   }
 
   return true;
 }
 
-bool ResourceManager::ResourceGroup::lookup(DataPack& dataPack, const WideString fileName, const bool fileNameOnly)
+// asynchronous lookups
+static const int IO_THREAD_COUNT = 2;
+
+ResourceRequest::ResourceRequest(const WideString& fileName, const WideString& groupName, 
+  const bool fileNameOnly, ResourceCallback callback) :
+  mFileName(fileName), mGroupName(groupName), mFileNameOnly(fileNameOnly), 
+  mCallback(callback), mFound(false), mComplete(0)
+{
+  mDone = CreateEvent(NULL, TRUE, FALSE, NULL);
+}
+
+ResourceRequest::~ResourceRequest()
 {
+  CloseHandle(mDone);
+}
+
+WideString const& ResourceRequest::getFileName() const
+{
+  return mFileName;
+}
+
+WideString const& ResourceRequest::getGroupName() const
+{
+  return mGroupName;
+}
+
+bool ResourceRequest::isComplete() const
+{
+  return mComplete != 0;
+}
+
+bool ResourceRequest::wait(const DWORD timeout)
+{
+  return isComplete() || (WaitForSingleObject(mDone, timeout) == WAIT_OBJECT_0);
+}
+
+bool ResourceRequest::isFound() const
+{
+  return mFound;
+}
+
+DataPack const& ResourceRequest::getDataPack() const
+{
+  return mDataPack;
+}
+
+ResourceManager::ResourceManager() : mIoThreads(NULL), mStatsInterval(0), mStatsDue(0)
+{
+}
+
+ResourceManager::~ResourceManager()
+{
+  // lookups still queued are dropped, the ones running finish first
+  delete mIoThreads;
+}
+
+ResourceTicket ResourceManager::lookupAsync(const WideString fileName, const WideString groupName, 
+  const bool fileNameOnly, ResourceCallback callback)
+{
+  if(mIoThreads == NULL)
+    mIoThreads = new WorkerPool(IO_THREAD_COUNT);
+
+  ResourceTicket request(new ResourceRequest(fileName, groupName, fileNameOnly, callback));
+  mIoThreads->submit(boost::bind(&ResourceManager::performLookup, this, request));
+  return request;
+}
+
+void ResourceManager::performLookup(ResourceTicket request)
+{
+  request->mFound = lookup(request->mDataPack, request->mFileName, 
+    request->mGroupName, request->mFileNameOnly) != 0;
+
+  // the results must be in place before anyone can see it's complete
+  InterlockedExchange(&request->mComplete, 1);
+  SetEvent(request->mDone);
+
+  if(request->mCallback)
+  {
+    ScopedLock lock(mCompletedLock);
+    mCompleted.push_back(request);
+  }
+}
+
+int ResourceManager::dispatchCompleted()
+{
+  std::deque<ResourceTicket> completed;
+  {
+    ScopedLock lock(mCompletedLock);
+    completed.swap(mCompleted);
+  }
+
+  // callbacks may start new lookups, they'll be seen on the next call
+  for(std::deque<ResourceTicket>::iterator iter = completed.begin(); iter != completed.end(); iter++)
+    (*iter)->mCallback(*iter);
+
+  return static_cast<int>(completed.size());
+}
+
+// stats
+void ResourceManager::update()
+{
+  dispatchCompleted();
+
+  for(Groups::iterator iter = mGroups.begin(); iter != mGroups.end(); iter++)
+    for(ResourceGroup::iterator store = iter->second.begin(); store != iter->second.end(); store++)
+      (*store)->update();
+
+  if(!mStatsFile.empty() && (static_cast<int>(GetTickCount() - mStatsDue) >= 0))
+  {
+    dumpStats();
+    mStatsDue = GetTickCount() + mStatsInterval;
+  }
+}
+
+void ResourceManager::getStats(std::vector<ResourceStats>& stats)
+{
+  ResourceStats totals;
+  totals.name = L"*";
+  mCounters.snapshot(totals);
+  stats.push_back(totals);
+
+  for(Groups::iterator iter = mGroups.begin(); iter != mGroups.end(); iter++)
+  {
+    ResourceStats group;
+    group.name = iter->first;
+    iter->second.getCounters().snapshot(group);
+    stats.push_back(group);
+  }
+
+  for(Groups::iterator iter = mGroups.begin(); iter != mGroups.end(); iter++)
+    for(ResourceGroup::iterator store = iter->second.begin(); store != iter->second.end(); store++)
+    {
+      ResourceStats storeStats;
+      storeStats.name = (*store)->getPathName();
+      (*store)->getCounters().snapshot(storeStats);
+      stats.push_back(storeStats);
+    }
+}
+
+void ResourceManager::resetStats()
+{
+  mCounters.reset();
+  for(Groups::iterator iter = mGroups.begin(); iter != mGroups.end(); iter++)
+  {
+    iter->second.getCounters().reset();
+    for(ResourceGroup::iterator store = iter->second.begin(); store != iter->second.end(); store++)
+      (*store)->getCounters().reset();
+  }
+}
+
+void ResourceManager::setStatsDump(const WideString& fileName, const double intervalSeconds)
+{
+  mStatsFile = fileName;
+  mStatsInterval = static_cast<DWORD>(intervalSeconds * 1000);
+  mStatsDue = GetTickCount() + mStatsInterval;
+}
+
+void ResourceManager::dumpStats()
+{
+  std::vector<ResourceStats> stats;
+  getStats(stats);
+
+  std::ofstream dest(UTF8String(mStatsFile).c_str(), std::ios::app);
+  dest << "-- resource lookups at " << GetTickCount() << "ms" << std::endl;
+  dest << "lookups\thits\tmisses\thit%\tbytes\tp50us\tp90us\tp99us\tname" << std::endl;
+  for(std::vector<ResourceStats>::iterator iter = stats.begin(); iter != stats.end(); iter++)
+  {
+    dest << iter->lookups << '\t' << iter->hits << '\t' << iter->misses() << '\t' 
+      << static_cast<int>(iter->hitRate() * 100) << '\t' << iter->bytesFound << '\t'
+      << iter->percentile(0.5) << '\t' << iter->percentile(0.9) << '\t' << iter->percentile(0.99) << '\t'
+      << UTF8String(iter->name).c_str() << std::endl;
+  }
+}
+
+bool ResourceManager::ResourceGroup::lookup(DataPack& dataPack, const WideString fileName, const bool fileNameOnly,
+  const bool diskPathsOnly)
+{
+  LONGLONG start = ResourceCounters::now();
   dataPack.cleanup();
-  iterator iter = std::find_if(begin(), end(), FindFile(dataPack, fileName, fileNameOnly));  
-  return iter != end();
+  iterator iter = std::find_if(begin(), end(), FindFile(dataPack, fileName, fileNameOnly, diskPathsOnly));  
+  bool found = iter != end();
+  mCounters.record(found, dataPack.getSize(), ResourceCounters::now() - start);
+  return found;
+}
+
+// the manifest's file lists, by resource-folders entry
+typedef std::map<WideString, StoreListing> FolderLists;
+
+static WideString folderKey(const WideString& folderName)
+{
+  WideString result = folderName;
+  std::transform(result.begin(), result.end(), result.begin(), towlower);
+  std::replace(result.begin(), result.end(), L'/', L'\\');
+  return result;
 }
 
-bool ResourceManager::initialize(MultipleSettings& settings, const WideString overridePath)
+static void readFolderLists(const ResourceManifest& manifest, FolderLists& lists)
+{
+  ManifestReader reader;
+  if(!manifest.getBlock(MANIFEST_FILES_BLOCK, reader))
+    return;
+
+  int folderCount = reader.readInt();
+  for(int i = 0; (i < folderCount) && !reader.failed(); i++)
+  {
+    StoreListing& listing = lists[reader.readString()];
+    int stampCount = reader.readInt();
+    for(int j = 0; (j < stampCount) && !reader.failed(); j++)
+    {
+      listing.folders.push_back(reader.readString());
+      listing.stamps.push_back(reader.readLong());
+    }
+    int fileCount = reader.readInt();
+    for(int j = 0; (j < fileCount) && !reader.failed(); j++)
+    {
+      listing.files.push_back(reader.readString());
+      listing.sizes.push_back(reader.readLong());
+    }
+  }
+
+  // a damaged block is as good as none, the folders get scanned
+  if(reader.failed())
+    lists.clear();
+}
+
+bool ResourceManager::initialize(MultipleSettings& settings, const WideString overridePath, 
+  const bool useManifest, const WideString rootPath)
 {
   // set internal paths 
   mOverridePath = overridePath;
-  mRootPath = string_utils::conditional_append_copy(NativeApplication::ApplicationPath(), '\\');
+  mRootPath = string_utils::conditional_append_copy(
+    rootPath.empty() ? NativeApplication::ApplicationPath() : rootPath, '\\');
+
+  if(settings.exists(CONFIG_STATS_SECTION))
+  {
+    Settings const& statsSettings = settings[CONFIG_STATS_SECTION];
+    if(statsSettings.exists(CONFIG_STATS_FILE))
+    {
+      double interval = statsSettings.exists(CONFIG_STATS_INTERVAL) ? 
+        string_utils::parse_double(statsSettings[CONFIG_STATS_INTERVAL].getValue(), 10.0) : 10.0;
+      setStatsDump(mRootPath + statsSettings[CONFIG_STATS_FILE].getValue(), interval);
+    }
+  }
 
   if(!settings.exists(CONFIG_FOLDERS_SECTION))
     return false;
 
-  Settings folderList = settings[CONFIG_FOLDERS_SECTION];
+  FolderLists folderLists;
+  mManifest.clear();
+  if(useManifest && mManifest.load(mRootPath + RESOURCE_MANIFEST_FILENAME))
+    readFolderLists(mManifest, folderLists);
+
+  Settings const& folderList = settings[CONFIG_FOLDERS_SECTION];
   for(int i = 0; i < static_cast<int>(folderList.size()); i++)
   {
-    Setting item = folderList[i];
+    Setting const& item = folderList[i];
     WideString folderName = mRootPath + item.getValue();
-    if(!bfs::exists(folderName) || !bfs::is_directory(folderName))
+    FolderLists::iterator listed = folderLists.empty() ? folderLists.end() : folderLists.find(folderKey(item.getValue()));
+    ResourceStore* store = createStore(folderName, (listed != folderLists.end()) ? &(listed->second) : NULL);
+    if(store == NULL)
       continue;
 
     Groups::iterator subj = mGroups.empty() ? mGroups.end() : mGroups.find(item.getName());
     if(subj != mGroups.end())
-      subj->second.add(new FileSystemStore(folderName));
+      subj->second.add(store);
     else
     {
       mGroups[item.getName()] = ResourceGroup();
-      mGroups[item.getName()].add(new FileSystemStore(folderName));
+      mGroups[item.getName()].add(store);
     }
   }
 
   return true;
 }
 
+ResourceManifest const& ResourceManager::getManifest() const
+{
+  return mManifest;
+}
+
+void ResourceManager::writeManifest(ResourceManifest& manifest)
+{
+  FolderLists folderLists;
+  for(Groups::iterator iter = mGroups.begin(); iter != mGroups.end(); iter++)
+    for(ResourceGroup::iterator store = iter->second.begin(); store != iter->second.end(); store++)
+    {
+      // stores are keyed the way their resource-folders entries read
+      WideString const& pathName = (*store)->getPathName();
+      if(pathName.compare(0, mRootPath.size(), mRootPath) != 0)
+        continue;
+
+      StoreListing listing;
+      if((*store)->listFiles(listing))
+        folderLists[folderKey(pathName.substr(mRootPath.size()))] = listing;
+    }
+
+  ManifestWriter writer;
+  writer.writeInt(static_cast<int>(folderLists.size()));
+  for(FolderLists::iterator iter = folderLists.begin(); iter != folderLists.end(); iter++)
+  {
+    StoreListing const& listing = iter->second;
+    writer.writeString(iter->first);
+    writer.writeInt(static_cast<int>(listing.folders.size()));
+    for(size_t i = 0; i < listing.folders.size(); i++)
+    {
+      writer.writeString(listing.folders[i]);
+      writer.writeLong(listing.stamps[i]);
+    }
+    writer.writeInt(static_cast<int>(listing.files.size()));
+    for(size_t i = 0; i < listing.files.size(); i++)
+    {
+      writer.writeString(listing.files[i]);
+      writer.writeLong(listing.sizes[i]);
+    }
+  }
+  manifest.setBlock(MANIFEST_FILES_BLOCK, writer);
+}
+
+void ResourceManager::refresh()
+{
+  for(Groups::iterator iter = mGroups.begin(); iter != mGroups.end(); iter++)
+    for(ResourceGroup::iterator store = iter->second.begin(); store != iter->second.end(); store++)
+      (*store)->refresh();
+}
+
+void ResourceManager::setWatching(const bool watching)
+{
+  for(Groups::iterator iter = mGroups.begin(); iter != mGroups.end(); iter++)
+    for(ResourceGroup::iterator store = iter->second.begin(); store != iter->second.end(); store++)
+      (*store)->setWatching(watching);
+}
+
+void ResourceManager::registerStore(const WideString& extension, StoreFactory factory)
+{
+  WideString key(extension);
+  std::transform(key.begin(), key.end(), key.begin(), towlower);
+  mStoreFactories[key] = factory;
+}
+
+ResourceStore* ResourceManager::createStore(const WideString& pathName, const StoreListing* listing)
+{
+  if(!bfs::exists(pathName))
+    return NULL;
+  if(bfs::is_directory(pathName))
+    return new FileSystemStore(pathName, listing);
+
+  // a file, see if anyone knows what to do with it
+  size_t dot = pathName.find_last_of(L".");
+  size_t slash = pathName.find_last_of(L"\\/");
+  if((dot == WideString::npos) || ((slash != WideString::npos) && (dot < slash)))
+    return NULL;
+
+  WideString extension = pathName.substr(dot);
+  std::transform(extension.begin(), extension.end(), extension.begin(), towlower);
+  StoreFactories::iterator subj = mStoreFactories.find(extension);
+  if(subj == mStoreFactories.end())
+    return NULL;
+
+  try
+  {
+    return subj->second(pathName);
+  }
+  catch(std::exception&)
+  {
+    return NULL;
+  }
+}
+
 int ResourceManager::lookup(DataPack& dataPack, const WideString fileName, 
   const WideString groupName, const bool fileNameOnly)
 {
+  LONGLONG start = ResourceCounters::now();
   bool found = false;
   if(groupName == GROUP_NAME_ANY)
   {
@@ -154,11 +701,14 @@ int ResourceManager::lookup(DataPack& dataPack, const WideString fileName,
       found = subj->second.lookup(dataPack, fileName, fileNameOnly);
   }
 
+  mCounters.record(found, dataPack.getSize(), ResourceCounters::now() - start);
   return found ? 1 : 0;
 }
 
 int ResourceManager::lookup(DataPacks& dataPacks, const WideString fileName, const bool fileNameOnly)
 {
+  LONGLONG start = ResourceCounters::now();
+  size_t bytes = 0;
   int foundCount = 0;
   for(Groups::iterator iter = mGroups.begin(); iter != mGroups.end(); iter++)
   {
@@ -168,17 +718,24 @@ int ResourceManager::lookup(DataPacks& dataPacks, const WideString fileName, con
     if(found)
     {
       dataPacks.push_back(dp);
+      bytes += dp.getSize();
       foundCount++;
     }
   }
 
+  mCounters.record(foundCount > 0, bytes, ResourceCounters::now() - start);
   return foundCount;
 }
 
 WideString ResourceManager::operator[](const WideString fileName)
 {
+  LONGLONG start = ResourceCounters::now();
   DataPack dp;
-  int count = lookup(dp, fileName, GROUP_NAME_ANY, true);
-  return count ? dp.getFileName() : L"";
+  bool found = false;
+  for(Groups::iterator iter = mGroups.begin(); (iter != mGroups.end()) && !found; iter++)
+    found = iter->second.lookup(dp, fileName, true, true);
+
+  mCounters.record(found, 0, ResourceCounters::now() - start);
+  return found ? dp.getFileName() : L"";
 }
 
@@ -41,6 +41,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "GjDefs.h"
 #include "GjTemplates.h"
 #include "GjSettings.h"
+#include "GjStringIndex.h"
+#include "GjThreads.h"
+#include "GjResourceManifest.h"
+#include "GjResourceStats.h"
+
+#include <boost/shared_ptr.hpp>
 
 namespace yaglib 
 {
@@ -49,87 +55,276 @@ class ResourceStore;
 class ResourceGroup;
 class ResourceManager;
 
+/**
+ * a resource's data.  the buffer behind it is reference counted: copies
+ * of a pack share it, and whatever backs it (a heap block, a mapped file,
+ * a mounted archive) is let go of when the last of them is gone.  the
+ * data is never copied on the way to whoever consumes it.
+ */
 class DataPack
 {
 public:
+  // keeps the data alive. its deleter releases whatever backs it.
+  typedef boost::shared_ptr<void> Buffer;
+
   DataPack() : mData(NULL), mSize(0) { };
-  virtual ~DataPack() { cleanup(); };
 
   void cleanup()
   {
-    SAFE_DELETE(mData);
+    mBuffer.reset();
+    mData = NULL;
     mSize = 0;
   };
 
   void* getData() const { return mData; };
   size_t getSize() const { return mSize; };
+  Buffer const& getBuffer() const { return mBuffer; };
 
-  void setData(void* data, const size_t size) 
-  { 
-    cleanup(); 
+  // data is size bytes somewhere within what buffer keeps alive
+  void setData(const Buffer& buffer, void* data, const size_t size)
+  {
+    mBuffer = buffer;
     mData = data;
     mSize = size;
   };
+  void setData(const Buffer& buffer, const size_t size) { setData(buffer, buffer.get(), size); };
+
+  // a heap block of size bytes for the pack to hold the data in
+  void* allocate(const size_t size);
 
   WideString const& getFileName() const { return mFileName; };
   void setFileName(const WideString& fileName) { mFileName = fileName; };
 
 private:
   WideString mFileName;
+  Buffer mBuffer;
   void* mData;
   size_t mSize;
 };
 
 typedef std::vector<DataPack> DataPacks;
 
+class ResourceRequest;
+typedef boost::shared_ptr<ResourceRequest> ResourceTicket;
+typedef boost::function<void (ResourceTicket)> ResourceCallback;
+
+/**
+ * one lookup started with ResourceManager::lookupAsync().  the data pack
+ * is filled in on an I/O thread; poll isComplete() or wait() for it, or
+ * leave it to the callback.  callbacks don't run on the I/O threads, but
+ * from ResourceManager::dispatchCompleted(), which the framework calls
+ * once a frame.
+ */
+class ResourceRequest : private boost::noncopyable
+{
+public:
+  ~ResourceRequest();
+
+  WideString const& getFileName() const;
+  WideString const& getGroupName() const;
+
+  bool isComplete() const;
+  bool wait(const DWORD timeout = INFINITE);
+
+  // only meaningful once complete
+  bool isFound() const;
+  DataPack const& getDataPack() const;
+
+private:
+  friend class ResourceManager;
+
+  ResourceRequest(const WideString& fileName, const WideString& groupName, 
+    const bool fileNameOnly, ResourceCallback callback);
+
+  WideString mFileName;
+  WideString mGroupName;
+  bool mFileNameOnly;
+  ResourceCallback mCallback;
+
+  DataPack mDataPack;
+  bool mFound;
+  volatile LONG mComplete;
+  HANDLE mDone;
+};
+
+// what a folder held when the manifest was written
+struct StoreListing
+{
+  std::vector<WideString> files;    // by relative path
+  std::vector<LONGLONG> sizes;      // of each of the files
+  std::vector<WideString> folders;  // by relative path, L"" for the top one
+  std::vector<LONGLONG> stamps;     // last write time of each of the folders
+};
+
 class ResourceStore
 {
 public:
   ResourceStore(const WideString& pathName);
+  virtual ~ResourceStore();
 
   WideString const& getPathName() const;
   virtual bool lookup(DataPack& dataPack, const WideString fileName, const bool fileNameOnly = false) = 0;
+  // false if the file names lookups give can't be opened from disk
+  virtual bool hasDiskPaths() const;
+
+  // stores that cache what they hold pick up changes made since. with
+  // watching on, they do that by themselves as changes happen.
+  virtual void refresh();
+  virtual void setWatching(const bool watching);
+
+  // every file the store holds, as the manifest keeps it. false if the
+  // store can't tell, or doesn't need a manifest to find them quickly.
+  virtual bool listFiles(StoreListing& listing);
+
+  // called by ResourceManager::update(), once a frame
+  virtual void update();
+
+  // every lookup made through the resource manager, found or not
+  ResourceCounters& getCounters();
 
 private:
   WideString mPathName;
+  ResourceCounters mCounters;
 };
 
+/**
+ * serves the files below a folder.  every file in the tree is indexed
+ * once, when the store is created, so a lookup is a hash probe (case
+ * and the kind of slash don't matter) and only files that are actually
+ * there are ever opened.  files added or removed later are only seen
+ * after a refresh, or right away while watching.
+ */
 class FileSystemStore : public ResourceStore
 {
 public:
-  FileSystemStore(const WideString& pathName);
+  // listing, if given, is what the folder held when the manifest was
+  // written. it's taken instead of a scan as long as none of the
+  // folders in it has had files added, removed or renamed since.
+  FileSystemStore(const WideString& pathName, const StoreListing* listing = NULL);
+  virtual ~FileSystemStore();
 
   virtual bool lookup(DataPack& dataPack, const WideString fileName, const bool fileNameOnly = false);
 
+  virtual void refresh();
+  virtual void setWatching(const bool watching);
+  virtual bool listFiles(StoreListing& listing);
+
 private:
   WideString mQualifiedPath;
+  StringIndex<NoCasePathChars> mIndex;  // relative paths of all the files
+  CriticalSection mLock;
+  HANDLE mChanges;    // change notifications, while watching
+
+  void collectFiles(const WideString& relativePath, StoreListing& listing, const bool stamped);
+  bool isCurrent(const StoreListing& listing);
+  void index(const std::vector<WideString>& files);
+  void reindex();
+  void checkChanges();
 };
 
 #define CONFIG_FOLDERS_SECTION            L"resource-folders"
+// optional: file=<name> [interval=<seconds>] turns on the stats dump
+#define CONFIG_STATS_SECTION              L"resource-stats"
+#define CONFIG_STATS_FILE                 L"file"
+#define CONFIG_STATS_INTERVAL             L"interval"
 #define GROUP_NAME_ANY                    WideString(L"")
 
+// creates a store for a resource-folders entry naming a file. it may
+// throw, or return NULL, if the file can't be used.
+typedef ResourceStore* (*StoreFactory)(const WideString& pathName);
+
 class ResourceManager : public Singleton<ResourceManager>
 {
 public:
-  bool initialize(MultipleSettings& settings, const WideString overridePath = L"");
+  ResourceManager();
+  ~ResourceManager();
+
+  // the resource-folders entries are relative to the application's
+  // folder, or to rootPath if one is given (overridePath doesn't move
+  // them). if there's a manifest there (see RESOURCE_MANIFEST_FILENAME),
+  // the folders it covers are taken from it instead of being scanned,
+  // those that have changed since it was written are still scanned.
+  bool initialize(MultipleSettings& settings, const WideString overridePath = L"", 
+    const bool useManifest = true, const WideString rootPath = L"");
+
+  // entries of the resource-folders section may name files, archives
+  // for instance, instead of folders. the store used for those is
+  // picked by the file's extension (e.g. L".vfs"), registered here
+  // before initialize() is called.
+  void registerStore(const WideString& extension, StoreFactory factory);
+
+  // see ResourceStore::refresh(), applies to every store
+  void refresh();
+  void setWatching(const bool watching);
 
   int lookup(DataPack& dataPack, const WideString fileName, 
     const WideString groupName = GROUP_NAME_ANY, const bool fileNameOnly = false);
   int lookup(DataPacks& dataPacks, const WideString fileName, const bool fileNameOnly = false);
 
+  // same as lookup(), but done on the I/O threads. the stores must be
+  // left alone (no initialize() or refresh()) while requests are out.
+  ResourceTicket lookupAsync(const WideString fileName, const WideString groupName = GROUP_NAME_ANY, 
+    const bool fileNameOnly = false, ResourceCallback callback = ResourceCallback());
+  // runs the callbacks of the requests completed so far, on the calling
+  // thread. returns how many ran.
+  int dispatchCompleted();
+
+  // the framework calls this once a frame. it runs dispatchCompleted(),
+  // updates the stores, and writes out the stats when they're due.
+  void update();
+
+  // lookup stats: the totals first (named "*"), then each group, then
+  // each store (named after its path)
+  void getStats(std::vector<ResourceStats>& stats);
+  void resetStats();
+  // appends the stats to fileName every intervalSeconds. an empty file
+  // name stops it.
+  void setStatsDump(const WideString& fileName, const double intervalSeconds = 10.0);
+
+  // what was loaded at initialize(), empty if there was nothing. other
+  // managers keep their own blocks in it.
+  ResourceManifest const& getManifest() const;
+  // adds the file lists of the resource folders, fresh from the disk,
+  // with the sizes of the files and the times the folders were written
+  void writeManifest(ResourceManifest& manifest);
+
+  // the file name the file can be opened from disk by, or an empty
+  // string. stores that can't give one, archives, are skipped, so 
+  // whatever opens files by name (fonts, sounds) can't be served from
+  // them.
   WideString operator[](const WideString fileName);
 
 private:
   class ResourceGroup : public ObjectList<ResourceStore>
   {
   public:
-    virtual bool lookup(DataPack& dataPack, const WideString fileName, const bool fileNameOnly);
+    virtual bool lookup(DataPack& dataPack, const WideString fileName, const bool fileNameOnly, 
+      const bool diskPathsOnly = false);
+    ResourceCounters& getCounters() { return mCounters; };
+  private:
+    ResourceCounters mCounters;
   };
 
   WideString mRootPath;
   WideString mOverridePath;
   typedef std::map<WideString, ResourceGroup> Groups;
   Groups mGroups;
+  typedef std::map<WideString, StoreFactory> StoreFactories;
+  StoreFactories mStoreFactories;
+  ResourceManifest mManifest;
+
+  WorkerPool* mIoThreads;   // created with the first async lookup
+  CriticalSection mCompletedLock;
+  std::deque<ResourceTicket> mCompleted;
+
+  ResourceCounters mCounters;   // all the lookups
+  WideString mStatsFile;
+  DWORD mStatsInterval;         // milliseconds
+  DWORD mStatsDue;
+
+  ResourceStore* createStore(const WideString& pathName, const StoreListing* listing);
+  void performLookup(ResourceTicket request);
+  void dumpStats();
 };
 
 
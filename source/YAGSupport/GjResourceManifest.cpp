@@ -0,0 +1,229 @@
+/*
+Yet Another Game Library
+Copyright (c) 2001-2007, Virgilio A. Blones, Jr. (vij_blones_jr@yahoo.com)
+See https://sourceforge.net/projects/yaglib/ for the latest updates.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, 
+      this list of conditions and the following disclaimer.
+      
+    * Redistributions in binary form must reproduce the above copyright notice, 
+      this list of conditions and the following disclaimer in the documentation 
+      and/or other materials provided with the distribution.
+      
+    * Neither the name of this library (YAGLib) nor the names of its contributors 
+      may be used to endorse or promote products derived from this software 
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "GjResourceManifest.h"
+#include "GjUnicodeUtils.h"
+#include <fstream>
+using namespace yaglib;
+
+static const int MANIFEST_SIGNATURE = 0x464D5259;   // "YRMF"
+static const int MANIFEST_VERSION = 3;
+
+struct ManifestHeader
+{
+  int signature;
+  int version;
+  int blockCount;
+};
+
+struct ManifestBlock
+{
+  unsigned int tag;
+  unsigned int offset;    // from the start of the file
+  unsigned int size;
+};
+
+// ManifestWriter
+void ManifestWriter::writeInt(const int value)
+{
+  const Byte* bytes = reinterpret_cast<const Byte*>(&value);
+  mData.insert(mData.end(), bytes, bytes + sizeof(int));
+}
+
+void ManifestWriter::writeLong(const LONGLONG value)
+{
+  const Byte* bytes = reinterpret_cast<const Byte*>(&value);
+  mData.insert(mData.end(), bytes, bytes + sizeof(LONGLONG));
+}
+
+void ManifestWriter::writeFloat(const float value)
+{
+  const Byte* bytes = reinterpret_cast<const Byte*>(&value);
+  mData.insert(mData.end(), bytes, bytes + sizeof(float));
+}
+
+void ManifestWriter::writeString(const WideString& value)
+{
+  writeInt(static_cast<int>(value.size()));
+  const Byte* bytes = reinterpret_cast<const Byte*>(value.c_str());
+  mData.insert(mData.end(), bytes, bytes + value.size() * sizeof(WideChar));
+}
+
+// ManifestReader
+const Byte* ManifestReader::take(const size_t size)
+{
+  if(mFailed || (size > mSize - mPosition))
+  {
+    mFailed = true;
+    return NULL;
+  }
+
+  const Byte* result = mData + mPosition;
+  mPosition += size;
+  return result;
+}
+
+int ManifestReader::readInt()
+{
+  int result = 0;
+  const Byte* bytes = take(sizeof(int));
+  if(bytes != NULL)
+    memcpy(&result, bytes, sizeof(int));
+  return result;
+}
+
+LONGLONG ManifestReader::readLong()
+{
+  LONGLONG result = 0;
+  const Byte* bytes = take(sizeof(LONGLONG));
+  if(bytes != NULL)
+    memcpy(&result, bytes, sizeof(LONGLONG));
+  return result;
+}
+
+float ManifestReader::readFloat()
+{
+  float result = 0;
+  const Byte* bytes = take(sizeof(float));
+  if(bytes != NULL)
+    memcpy(&result, bytes, sizeof(float));
+  return result;
+}
+
+WideString ManifestReader::readString()
+{
+  int length = readInt();
+  if(length < 0)
+    mFailed = true;
+  if(mFailed || (length == 0))
+    return WideString();
+
+  const Byte* bytes = take(length * sizeof(WideChar));
+  if(bytes == NULL)
+    return WideString();
+
+  WideString result(length, 0);
+  memcpy(&result[0], bytes, length * sizeof(WideChar));
+  return result;
+}
+
+// ResourceManifest
+bool ResourceManifest::load(const WideString& fileName)
+{
+  clear();
+
+  // the whole file in one read, then split into the blocks
+  std::ifstream source(UTF8String(fileName).c_str(), std::ios::binary);
+  if(!source.good())
+    return false;
+  source.seekg(0, std::ios_base::end);
+  size_t size = source.tellg();
+  source.seekg(0, std::ios_base::beg);
+  if(size < sizeof(ManifestHeader))
+    return false;
+
+  std::vector<Byte> data(size);
+  source.read(reinterpret_cast<char*>(&data[0]), static_cast<std::streamsize>(size));
+  if(!source.good())
+    return false;
+
+  const ManifestHeader* header = reinterpret_cast<const ManifestHeader*>(&data[0]);
+  if((header->signature != MANIFEST_SIGNATURE) || (header->version != MANIFEST_VERSION) || 
+     (header->blockCount < 0) || 
+     (static_cast<size_t>(header->blockCount) > (size - sizeof(ManifestHeader)) / sizeof(ManifestBlock)))
+    return false;
+
+  const ManifestBlock* blocks = reinterpret_cast<const ManifestBlock*>(&data[sizeof(ManifestHeader)]);
+  for(int i = 0; i < header->blockCount; i++)
+  {
+    const ManifestBlock& block = blocks[i];
+    if((block.offset > size) || (block.size > size - block.offset))
+    {
+      clear();
+      return false;
+    }
+    mBlocks[block.tag].assign(data.begin() + block.offset, data.begin() + block.offset + block.size);
+  }
+
+  return true;
+}
+
+bool ResourceManifest::save(const WideString& fileName) const
+{
+  std::ofstream dest(UTF8String(fileName).c_str(), std::ios::binary | std::ios::trunc);
+  if(!dest.good())
+    return false;
+
+  ManifestHeader header = { MANIFEST_SIGNATURE, MANIFEST_VERSION, static_cast<int>(mBlocks.size()) };
+  dest.write(reinterpret_cast<const char*>(&header), sizeof(ManifestHeader));
+
+  // the block table, with the blocks following in the same order
+  unsigned int offset = static_cast<unsigned int>(sizeof(ManifestHeader) + mBlocks.size() * sizeof(ManifestBlock));
+  for(Blocks::const_iterator iter = mBlocks.begin(); iter != mBlocks.end(); iter++)
+  {
+    ManifestBlock block = { iter->first, offset, static_cast<unsigned int>(iter->second.size()) };
+    dest.write(reinterpret_cast<const char*>(&block), sizeof(ManifestBlock));
+    offset += block.size;
+  }
+
+  for(Blocks::const_iterator iter = mBlocks.begin(); iter != mBlocks.end(); iter++)
+    if(!iter->second.empty())
+      dest.write(reinterpret_cast<const char*>(&iter->second[0]), static_cast<std::streamsize>(iter->second.size()));
+
+  return dest.good();
+}
+
+void ResourceManifest::clear()
+{
+  mBlocks.clear();
+}
+
+bool ResourceManifest::empty() const
+{
+  return mBlocks.empty();
+}
+
+void ResourceManifest::setBlock(const unsigned int tag, const ManifestWriter& writer)
+{
+  mBlocks[tag] = writer.getData();
+}
+
+bool ResourceManifest::getBlock(const unsigned int tag, ManifestReader& reader) const
+{
+  Blocks::const_iterator subj = mBlocks.find(tag);
+  if(subj == mBlocks.end())
+    return false;
+
+  reader = subj->second.empty() ? ManifestReader() : ManifestReader(&subj->second[0], subj->second.size());
+  return true;
+}
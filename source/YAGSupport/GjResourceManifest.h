@@ -0,0 +1,122 @@
+/*
+Yet Another Game Library
+Copyright (c) 2001-2007, Virgilio A. Blones, Jr. (vij_blones_jr@yahoo.com)
+See https://sourceforge.net/projects/yaglib/ for the latest updates.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, 
+      this list of conditions and the following disclaimer.
+      
+    * Redistributions in binary form must reproduce the above copyright notice, 
+      this list of conditions and the following disclaimer in the documentation 
+      and/or other materials provided with the distribution.
+      
+    * Neither the name of this library (YAGLib) nor the names of its contributors 
+      may be used to endorse or promote products derived from this software 
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/** 
+ * @file  GjResourceManifest.h
+ * @brief Build-time index of the resource folders and their metadata
+ *
+ * The manifest is a header followed by tagged blocks.  The resource 
+ * manager keeps the file lists of the resource folders in one, the 
+ * metadata manager its parsed metadata in another.  It is read in a 
+ * single go at startup, and saves scanning folders and parsing INI 
+ * files wherever it covers them.
+ *
+ */
+#ifndef GJ_RESOURCE_MANIFEST_HEADER
+#define GJ_RESOURCE_MANIFEST_HEADER
+
+#include "GjDefs.h"
+
+namespace yaglib 
+{
+
+#define RESOURCE_MANIFEST_FILENAME    L"resources.manifest"
+
+// block tags, four characters each
+static const unsigned int MANIFEST_FILES_BLOCK = 0x534C4946;    // "FILS"
+static const unsigned int MANIFEST_META_BLOCK = 0x4154454D;     // "META"
+
+/* appends values to a block being built */
+class ManifestWriter
+{
+public:
+  void writeInt(const int value);
+  void writeLong(const LONGLONG value);
+  void writeFloat(const float value);
+  void writeString(const WideString& value);
+
+  std::vector<Byte> const& getData() const { return mData; };
+
+private:
+  std::vector<Byte> mData;
+};
+
+/* reads values back out of a block.  reading past the end gives zeroes
+   and empty strings, and marks the reader as failed, so callers only 
+   need to check once, when they're done. */
+class ManifestReader
+{
+public:
+  ManifestReader() : mData(NULL), mSize(0), mPosition(0), mFailed(false) {};
+  ManifestReader(const Byte* data, const size_t size) : 
+    mData(data), mSize(size), mPosition(0), mFailed(false) {};
+
+  int readInt();
+  LONGLONG readLong();
+  float readFloat();
+  WideString readString();
+
+  bool failed() const { return mFailed; };
+  bool atEnd() const { return mPosition >= mSize; };
+
+private:
+  const Byte* mData;
+  size_t mSize;
+  size_t mPosition;
+  bool mFailed;
+
+  const Byte* take(const size_t size);
+};
+
+class ResourceManifest
+{
+public:
+  bool load(const WideString& fileName);
+  bool save(const WideString& fileName) const;
+  void clear();
+  bool empty() const;
+
+  // replaces the block with the given tag
+  void setBlock(const unsigned int tag, const ManifestWriter& writer);
+  // false if there is no such block. the reader is only good for as
+  // long as the manifest isn't changed.
+  bool getBlock(const unsigned int tag, ManifestReader& reader) const;
+
+private:
+  typedef std::map<unsigned int, std::vector<Byte> > Blocks;
+  Blocks mBlocks;
+};
+
+} /* namespace yaglib */
+
+#endif /* GJ_RESOURCE_MANIFEST_HEADER */
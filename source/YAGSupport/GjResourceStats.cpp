@@ -0,0 +1,139 @@
+/*
+Yet Another Game Library
+Copyright (c) 2001-2007, Virgilio A. Blones, Jr. (vij_blones_jr@yahoo.com)
+See https://sourceforge.net/projects/yaglib/ for the latest updates.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, 
+      this list of conditions and the following disclaimer.
+      
+    * Redistributions in binary form must reproduce the above copyright notice, 
+      this list of conditions and the following disclaimer in the documentation 
+      and/or other materials provided with the distribution.
+      
+    * Neither the name of this library (YAGLib) nor the names of its contributors 
+      may be used to endorse or promote products derived from this software 
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "GjResourceStats.h"
+using namespace yaglib;
+
+static LONGLONG ticksPerMicrosecond()
+{
+  static LONGLONG result = 0;
+  if(result == 0)
+  {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    result = (frequency.QuadPart >= 1000000) ? (frequency.QuadPart / 1000000) : 1;
+  }
+  return result;
+}
+
+// ResourceStats
+ResourceStats::ResourceStats() : lookups(0), hits(0), bytesFound(0)
+{
+  memset(latency, 0, sizeof(latency));
+}
+
+long ResourceStats::misses() const
+{
+  return lookups - hits;
+}
+
+double ResourceStats::hitRate() const
+{
+  return (lookups > 0) ? (double)hits / (double)lookups : 0.0;
+}
+
+double ResourceStats::percentile(const double fraction) const
+{
+  long total = 0;
+  for(int i = 0; i < LATENCY_BUCKETS; i++)
+    total += latency[i];
+  if(total == 0)
+    return 0.0;
+
+  double wanted = fraction * (double)total;
+  long sofar = 0;
+  for(int i = 0; i < LATENCY_BUCKETS; i++)
+  {
+    sofar += latency[i];
+    if((double)sofar >= wanted)
+      return (double)(1 << i);
+  }
+  return (double)(1 << (LATENCY_BUCKETS - 1));
+}
+
+void ResourceStats::add(const ResourceStats& other)
+{
+  lookups += other.lookups;
+  hits += other.hits;
+  bytesFound += other.bytesFound;
+  for(int i = 0; i < LATENCY_BUCKETS; i++)
+    latency[i] += other.latency[i];
+}
+
+// ResourceCounters
+ResourceCounters::ResourceCounters()
+{
+  reset();
+}
+
+void ResourceCounters::record(const bool found, const size_t bytes, const LONGLONG ticks)
+{
+  InterlockedIncrement(&mLookups);
+  if(found)
+  {
+    InterlockedIncrement(&mHits);
+    InterlockedExchangeAdd64(&mBytes, static_cast<LONGLONG>(bytes));
+  }
+
+  LONGLONG microseconds = ticks / ticksPerMicrosecond();
+  int bucket = 0;
+  while((bucket < LATENCY_BUCKETS - 1) && (microseconds >= (1 << bucket)))
+    bucket++;
+  InterlockedIncrement(&mLatency[bucket]);
+}
+
+void ResourceCounters::reset()
+{
+  mLookups = 0;
+  mHits = 0;
+  mBytes = 0;
+  for(int i = 0; i < LATENCY_BUCKETS; i++)
+    mLatency[i] = 0;
+}
+
+void ResourceCounters::snapshot(ResourceStats& stats) const
+{
+  stats.lookups = mLookups;
+  stats.hits = mHits;
+  // a plain read of 64 bits can tear on 32 bit targets
+  stats.bytesFound = InterlockedCompareExchange64(const_cast<volatile LONGLONG*>(&mBytes), 0, 0);
+  for(int i = 0; i < LATENCY_BUCKETS; i++)
+    stats.latency[i] = mLatency[i];
+}
+
+LONGLONG ResourceCounters::now()
+{
+  LARGE_INTEGER ticks;
+  QueryPerformanceCounter(&ticks);
+  return ticks.QuadPart;
+}
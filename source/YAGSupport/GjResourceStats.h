@@ -0,0 +1,97 @@
+/*
+Yet Another Game Library
+Copyright (c) 2001-2007, Virgilio A. Blones, Jr. (vij_blones_jr@yahoo.com)
+See https://sourceforge.net/projects/yaglib/ for the latest updates.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, 
+      this list of conditions and the following disclaimer.
+      
+    * Redistributions in binary form must reproduce the above copyright notice, 
+      this list of conditions and the following disclaimer in the documentation 
+      and/or other materials provided with the distribution.
+      
+    * Neither the name of this library (YAGLib) nor the names of its contributors 
+      may be used to endorse or promote products derived from this software 
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/** 
+ * @file  GjResourceStats.h
+ * @brief Counters and latency histograms for resource lookups
+ *
+ * Recording a lookup is a handful of interlocked adds, cheap enough to
+ * be left on in release builds.  The counters are read through plain
+ * snapshots (ResourceStats), which may be a lookup or two behind.
+ *
+ */
+#ifndef GJ_RESOURCE_STATS_HEADER
+#define GJ_RESOURCE_STATS_HEADER
+
+#include "GjDefs.h"
+
+namespace yaglib 
+{
+
+// bucket i of a latency histogram holds the lookups that took at least
+// 2^(i-1) but less than 2^i microseconds; bucket 0 those under one, and
+// the last one everything slower than the one before it.
+#define LATENCY_BUCKETS   24
+
+struct ResourceStats
+{
+  WideString name;
+  long lookups;
+  long hits;
+  LONGLONG bytesFound;    // the size of what the hits returned
+  long latency[LATENCY_BUCKETS];
+
+  ResourceStats();
+
+  long misses() const;
+  double hitRate() const;
+  // the latency, in microseconds, that the given fraction of the lookups
+  // stayed under. it's the bucket's upper bound, so it rounds up.
+  double percentile(const double fraction) const;
+
+  void add(const ResourceStats& other);
+};
+
+/* the live counters, safe to update from any thread */
+class ResourceCounters
+{
+public:
+  ResourceCounters();
+
+  // ticks are from QueryPerformanceCounter()
+  void record(const bool found, const size_t bytes, const LONGLONG ticks);
+  void reset();
+  void snapshot(ResourceStats& stats) const;
+
+  static LONGLONG now();
+
+private:
+  volatile LONG mLookups;
+  volatile LONG mHits;
+  volatile LONGLONG mBytes;
+  volatile LONG mLatency[LATENCY_BUCKETS];
+};
+
+} /* namespace yaglib */
+
+#endif /* GJ_RESOURCE_STATS_HEADER */
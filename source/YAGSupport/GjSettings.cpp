@@ -40,15 +40,16 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/lambda/bind.hpp>
 using namespace yaglib;
 
-Setting::Setting(const WideString& name, const WideString& value) : mPair(name, value)
+Setting::Setting(const WideString& name, const WideString& value) : mPair(name, value), mGeneration(0)
 {
 }
 
-Setting::Setting(const WideString& value) : mPair(string_utils::make_string_pair(value, '='))
+Setting::Setting(const WideString& value) : mPair(string_utils::make_string_pair(value, '=')), 
+  mGeneration(0)
 {
 }
 
-Setting::Setting(const StringPair& pair) : mPair(pair)
+Setting::Setting(const StringPair& pair) : mPair(pair), mGeneration(0)
 {
 }
 
@@ -65,38 +66,42 @@ const WideString& Setting::getValue() const
 void Setting::setValue(const WideString& newValue) 
 { 
   mPair.second = newValue; 
+  mGeneration++;
 }
 
 //
 Settings::Settings(const WideString name, const bool acceptDuplicates) :
-  mName(name), mAcceptDuplicates(acceptDuplicates)
+  mName(name), mAcceptDuplicates(acceptDuplicates), mLayout(0)
 {
 }
 
 // note: if we already have a setting with the same name, and duplicates
 //       are not allowed, then the previous one WILL be changed instead
-void Settings::add(Setting setting)
+void Settings::add(const Setting& setting)
 {
-  using namespace boost;
-  using namespace boost::lambda;
-  _listType::iterator result = std::find_if(mItems.begin(), mItems.end(), _1 == setting.getName());
-  if((result != mItems.end()) && !mAcceptDuplicates)
-    result->setValue(setting.getValue());
+  int index = mIndex.find(setting.getName());
+  if((index != StringIndex<>::npos) && !mAcceptDuplicates)
+    mItems[index].setValue(setting.getValue());
   else
+  {
+    if(index == StringIndex<>::npos)
+      mIndex.insert(setting.getName(), static_cast<int>(mItems.size()));
     mItems.push_back(setting);
+    mLayout++;
+  }
 }
 
-void Settings::add(StringPair pair)
+void Settings::add(const StringPair& pair)
 {
   add(Setting(pair));
 }
 
-void Settings::add(const WideString value)
+void Settings::add(const WideString& value)
 {
   add(Setting(value));
 }
 
-void Settings::add(const WideString name, const WideString value)
+void Settings::add(const WideString& name, const WideString& value)
 {
   add(Setting(name, value));
 }
@@ -104,28 +109,48 @@ void Settings::add(const WideString name, const WideString value)
 void Settings::clear()
 {
   mItems.clear();
+  mIndex.clear();
+  mLayout++;
 }
 
-void Settings::erase(const WideString name, const bool allCopies)
+void Settings::erase(const WideString& name, const bool allCopies)
 {
   using namespace boost;
   using namespace boost::lambda;
   if(allCopies)
-    std::remove_if(mItems.begin(), mItems.end(), _1 == name);
+    mItems.erase(std::remove_if(mItems.begin(), mItems.end(), _1 == name), mItems.end());
   else
   {
-    _listType::iterator result = std::find_if(mItems.begin(), mItems.end(), _1 == name);
-    if(result != mItems.end())
-      mItems.erase(result);
+    int index = mIndex.find(name);
+    if(index == StringIndex<>::npos)
+      return;
+    mItems.erase(mItems.begin() + index);
   }
+
+  // everything after it moved down, it's rare enough to just start over
+  reindex();
+  mLayout++;
+}
+
+void Settings::reserve(const size_t count)
+{
+  mItems.reserve(mItems.size() + count);
+  mIndex.reserve(mItems.size() + count);
+  // the settings may have moved
+  mLayout++;
+}
+
+void Settings::reindex()
+{
+  mIndex.clear();
+  mIndex.reserve(mItems.size());
+  for(int i = static_cast<int>(mItems.size()) - 1; i >= 0; i--)
+    mIndex.insert(mItems[i].getName(), i);
 }
 
 bool Settings::exists(const WideString& name) const
 {
-  using namespace boost;
-  using namespace boost::lambda;
-  _listType::const_iterator result = std::find_if(mItems.begin(), mItems.end(), _1 == name);
-  return result != mItems.end();
+  return mIndex.find(name) != StringIndex<>::npos;
 }
 
 size_t Settings::size() const
@@ -133,15 +158,10 @@ size_t Settings::size() const
   return mItems.size();
 }
 
-Setting* Settings::get(const WideString name) 
+Setting* Settings::get(const WideString& name) 
 {
-  using namespace boost;
-  using namespace boost::lambda;
-  _listType::iterator result = std::find_if(mItems.begin(), mItems.end(), _1 == name);
-  if(result != mItems.end())
-    return &(*result);
-  else
-    return NULL;
+  int index = mIndex.find(name);
+  return (index != StringIndex<>::npos) ? &(mItems[index]) : NULL;
 }
 
 Setting* Settings::get(const int index) 
@@ -152,7 +172,17 @@ Setting* Settings::get(const int index)
     return NULL;
 }
 
-Setting& Settings::operator[](const WideString name) 
+Setting const* Settings::get(const WideString& name) const
+{
+  return const_cast<Settings*>(this)->get(name);
+}
+
+Setting const* Settings::get(const int index) const
+{
+  return const_cast<Settings*>(this)->get(index);
+}
+
+Setting& Settings::operator[](const WideString& name) 
 {
   Setting* item = get(name);
   assert(item != NULL);
@@ -166,6 +196,20 @@ Setting& Settings::operator[](const int index)
   return *item;
 }
 
+Setting const& Settings::operator[](const WideString& name) const
+{
+  Setting const* item = get(name);
+  assert(item != NULL);
+  return *item;
+}
+
+Setting const& Settings::operator[](const int index) const
+{
+  Setting const* item = get(index);
+  assert(item != NULL);
+  return *item;
+}
+
 WideString const& Settings::getName() const
 {
   return mName;
@@ -177,22 +221,14 @@ bool Settings::duplicatesOk() const
 }
 
 
-MultipleSettings::MultipleSettings(const bool acceptDuplicates) : mAcceptDuplicates(acceptDuplicates)
+MultipleSettings::MultipleSettings(const bool acceptDuplicates) : mAcceptDuplicates(acceptDuplicates),
+  mLayout(0)
 {
 }
 
-Settings& MultipleSettings::operator[](const WideString name)
+Settings& MultipleSettings::operator[](const WideString& name)
 {
-  using namespace boost;
-  using namespace boost::lambda;
-  MultiSettings::iterator result = std::find_if(mItems.begin(), mItems.end(), _1 == name);
-  if(result == mItems.end())
-  {
-    mItems.push_back(Settings(name, mAcceptDuplicates));
-    result = mItems.end()-1;
-  }
-
-  return *result;
+  return *get(name, true);
 }
 
 Settings& MultipleSettings::operator[](const int index)
@@ -201,18 +237,31 @@ Settings& MultipleSettings::operator[](const int index)
   return mItems[index];
 }
 
-Settings* MultipleSettings::get(const WideString name, const bool forceCreate)
+Settings const& MultipleSettings::operator[](const WideString& name) const
 {
-  using namespace boost;
-  using namespace boost::lambda;
-  MultiSettings::iterator result = std::find_if(mItems.begin(), mItems.end(), _1 == name);
-  if((result == mItems.end()) && forceCreate)
-  {
-    mItems.push_back(Settings(name, mAcceptDuplicates));
-    result = mItems.end()-1;
-  }
+  Settings const* group = get(name);
+  assert(group != NULL);
+  return *group;
+}
 
-  return result != mItems.end() ? &(*result) : NULL;
+Settings const& MultipleSettings::operator[](const int index) const
+{
+  assert((index >= 0) && (index < static_cast<int>(mItems.size())));
+  return mItems[index];
+}
+
+Settings* MultipleSettings::get(const WideString& name, const bool forceCreate)
+{
+  int index = mIndex.find(name);
+  if(index != StringIndex<>::npos)
+    return &(mItems[index]);
+  if(!forceCreate)
+    return NULL;
+
+  mIndex.insert(name, static_cast<int>(mItems.size()));
+  mItems.push_back(Settings(name, mAcceptDuplicates));
+  mLayout++;
+  return &(mItems.back());
 }
 
 Settings* MultipleSettings::get(const int index)
@@ -223,12 +272,19 @@ Settings* MultipleSettings::get(const int index)
   return &(mItems[index]);
 }
 
-bool MultipleSettings::exists(const WideString groupName) const
+Settings const* MultipleSettings::get(const WideString& name) const
 {
-  using namespace boost;
-  using namespace boost::lambda;
-  MultiSettings::const_iterator result = std::find_if(mItems.begin(), mItems.end(), _1 == groupName);
-  return result != mItems.end();
+  return const_cast<MultipleSettings*>(this)->get(name, false);
+}
+
+Settings const* MultipleSettings::get(const int index) const
+{
+  return const_cast<MultipleSettings*>(this)->get(index);
+}
+
+bool MultipleSettings::exists(const WideString& groupName) const
+{
+  return mIndex.find(groupName) != StringIndex<>::npos;
 }
 
 bool MultipleSettings::duplicatesOk() const
@@ -244,14 +300,14 @@ size_t MultipleSettings::size() const
 void MultipleSettings::clear()
 {
   mItems.clear();
+  mIndex.clear();
+  mLayout++;
 }
 
-Setting* MultipleSettings::find(const WideString group, const WideString name) 
+Setting* MultipleSettings::find(const WideString& group, const WideString& name) 
 {
-  using namespace boost;
-  using namespace boost::lambda;
-  MultiSettings::iterator result = std::find_if(mItems.begin(), mItems.end(), _1 == group);
-  return (result == mItems.end()) ? NULL : result->get(name);
+  Settings* settings = get(group, false);
+  return (settings == NULL) ? NULL : settings->get(name);
 }
 
 WideString MultipleSettings::read(const WideString group, const WideString name, const WideString defVal)
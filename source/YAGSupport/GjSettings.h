@@ -40,6 +40,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "GjDefs.h"
 #include "GjTemplates.h"
+#include "GjStringIndex.h"
+#include "GjStringUtils.h"
 #include <utility>
 
 namespace yaglib 
@@ -59,6 +61,9 @@ public:
   const WideString& getValue() const;
   void setValue(const WideString& newValue);
 
+  // moves on whenever this setting's value changes. see SettingRef.
+  unsigned int getGeneration() const { return mGeneration; };
+
   const bool operator==(const WideString& name) const
   {
     return mPair.first == name;
@@ -66,8 +71,11 @@ public:
 
 private:
   StringPair mPair;
+  unsigned int mGeneration;
 };
 
+/* settings keep the order they were added in, and are found by name 
+   through a hash index. with duplicates, a name finds the first one. */
 class Settings 
 {
 public:
@@ -83,28 +91,45 @@ public:
   {
     return mItems.end();
   }
+  const_iterator begin() const
+  {
+    return mItems.begin();
+  };
+  const_iterator end() const
+  {
+    return mItems.end();
+  }
 
   Settings(const WideString name, const bool acceptDuplicates = false);
 
-  void add(Setting setting);
-  void add(StringPair pair);
-  void add(const WideString value);
-  void add(const WideString name, const WideString value);
+  void add(const Setting& setting);
+  void add(const StringPair& pair);
+  void add(const WideString& value);
+  void add(const WideString& name, const WideString& value);
 
   void clear();
-  void erase(const WideString name, const bool allCopies = false);
+  void erase(const WideString& name, const bool allCopies = false);
+  // room for that many more settings
+  void reserve(const size_t count);
 
   bool exists(const WideString& name) const;
   size_t size() const;
 
-  Setting* get(const WideString name);
+  Setting* get(const WideString& name);
   Setting* get(const int index);
+  Setting const* get(const WideString& name) const;
+  Setting const* get(const int index) const;
 
-  Setting& operator[](const WideString name);
+  Setting& operator[](const WideString& name);
   Setting& operator[](const int index);
+  Setting const& operator[](const WideString& name) const;
+  Setting const& operator[](const int index) const;
 
   WideString const& getName() const;
   bool duplicatesOk() const;
+  // moves on whenever settings are added or removed, and pointers to
+  // them may have gone bad
+  unsigned int getLayout() const { return mLayout; };
 
   const bool operator==(const WideString& name) const
   {
@@ -114,24 +139,38 @@ public:
 private:
   WideString mName;
   _listType mItems;
+  StringIndex<> mIndex;     // name to the first setting by that name
   bool mAcceptDuplicates;
+  unsigned int mLayout;
+
+  void reindex();
 };
 
+/* groups of settings, in the order they were added, found by name
+   through a hash index. references to groups stay good only until the
+   next group is added (the non-const operator[] and get() add missing
+   ones); hold on to them through those and they may dangle. */
 class MultipleSettings
 {
 public:
   MultipleSettings(const bool acceptDuplicates = true);
 
-  Settings& operator[](const WideString name);
+  Settings& operator[](const WideString& name);
   Settings& operator[](const int index);
+  Settings const& operator[](const WideString& name) const;
+  Settings const& operator[](const int index) const;
 
-  Settings* get(const WideString name, const bool forceCreate = true);
+  Settings* get(const WideString& name, const bool forceCreate = true);
   Settings* get(const int index);
+  Settings const* get(const WideString& name) const;
+  Settings const* get(const int index) const;
 
-  bool exists(const WideString groupName) const;
+  bool exists(const WideString& groupName) const;
   bool duplicatesOk() const;
   size_t size() const;
   void clear();
+  // moves on whenever groups are added or removed
+  unsigned int getLayout() const { return mLayout; };
 
   WideString read(const WideString group, const WideString name, const WideString defVal);
   int read(const WideString group, const WideString name, const int defVal);
@@ -141,9 +180,85 @@ public:
 private:
   typedef std::vector<Settings> MultiSettings;
   MultiSettings mItems;
+  StringIndex<> mIndex;     // group name to its position
   bool mAcceptDuplicates;
+  unsigned int mLayout;
+
+  Setting* find(const WideString& group, const WideString& name);
+};
+
+/* the value of a setting, looked up and parsed once, the same way
+   MultipleSettings::read() does it.  the lookup is redone only when
+   groups, or settings in its group, come or go (see getLayout()), and 
+   the parse only when the setting itself changes (see getGeneration()),
+   so reading a handle is mostly a few compares and a load.  missing 
+   settings read as the default.  the settings must outlive the handle,
+   and, like the settings themselves, it's for one thread at a time. */
+template<class T> class SettingRef
+{
+public:
+  SettingRef(const MultipleSettings& settings, const WideString& group, const WideString& name, 
+    const T defVal = T()) : 
+    mSettings(&settings), mGroupName(group), mName(name), mDefault(defVal), mValue(defVal),
+    mExists(false), mLayout(settings.getLayout() - 1), mGroup(NULL), mGroupLayout(0),
+    mItem(NULL), mGeneration(0)
+  {};
+
+  const T& get() const
+  {
+    if((mLayout != mSettings->getLayout()) || 
+       ((mGroup != NULL) && (mGroupLayout != mGroup->getLayout())))
+      refresh();
+    else if((mItem != NULL) && (mGeneration != mItem->getGeneration()))
+      reparse();
+    return mValue;
+  };
+  operator const T&() const { return get(); };
+
+  bool exists() const 
+  { 
+    get(); 
+    return mExists; 
+  };
+
+private:
+  const MultipleSettings* mSettings;
+  WideString mGroupName;
+  WideString mName;
+  T mDefault;
+  mutable T mValue;
+  mutable bool mExists;
+
+  // where the setting was found, good while the layouts haven't moved
+  mutable unsigned int mLayout;
+  mutable Settings const* mGroup;
+  mutable unsigned int mGroupLayout;
+  mutable Setting const* mItem;
+  mutable unsigned int mGeneration;
+
+  void refresh() const
+  {
+    mLayout = mSettings->getLayout();
+    mGroup = mSettings->get(mGroupName);
+    mGroupLayout = (mGroup != NULL) ? mGroup->getLayout() : 0;
+    mItem = (mGroup != NULL) ? mGroup->get(mName) : NULL;
+    mExists = mItem != NULL;
+    if(mExists)
+      reparse();
+    else
+      mValue = mDefault;
+  };
+
+  void reparse() const
+  {
+    mValue = parse(mItem->getValue(), mDefault);
+    mGeneration = mItem->getGeneration();
+  };
 
-  Setting* find(const WideString group, const WideString name);
+  static WideString parse(const WideString& value, const WideString& defVal) { return value; };
+  static int parse(const WideString& value, const int defVal) { return string_utils::parse_int(value, defVal); };
+  static double parse(const WideString& value, const double defVal) { return string_utils::parse_double(value, defVal); };
+  static bool parse(const WideString& value, const bool defVal) { return string_utils::parse_bool(value, defVal); };
 };
 
 class SettingsStore
@@ -0,0 +1,227 @@
+/*
+Yet Another Game Library
+Copyright (c) 2001-2007, Virgilio A. Blones, Jr. (vij_blones_jr@yahoo.com)
+See https://sourceforge.net/projects/yaglib/ for the latest updates.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, 
+      this list of conditions and the following disclaimer.
+      
+    * Redistributions in binary form must reproduce the above copyright notice, 
+      this list of conditions and the following disclaimer in the documentation 
+      and/or other materials provided with the distribution.
+      
+    * Neither the name of this library (YAGLib) nor the names of its contributors 
+      may be used to endorse or promote products derived from this software 
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/** 
+ * @file  GjStringIndex.h
+ * @brief Open-addressing hash index from strings to integer values
+ *
+ * Keys are interned into a single character pool, so the index holds
+ * no per-key heap objects.  Lookups take a pointer and a length and
+ * never allocate.  The character traits decide which characters are
+ * considered equal (e.g. path separators or case).
+ *
+ */
+#ifndef GJ_STRING_INDEX_HEADER
+#define GJ_STRING_INDEX_HEADER
+
+#include "GjDefs.h"
+#include <cwctype>
+
+namespace yaglib 
+{
+
+/* keys must match exactly */
+struct ExactChars
+{
+  static inline WideChar normalize(const WideChar c) { return c; };
+};
+
+/* '\' and '/' are the same thing */
+struct PathChars
+{
+  static inline WideChar normalize(const WideChar c) { return (c == '\\') ? '/' : c; };
+};
+
+/* same as PathChars, but case does not matter either (windows file names) */
+struct NoCasePathChars
+{
+  static inline WideChar normalize(const WideChar c) 
+  { 
+    return (c == '\\') ? '/' : static_cast<WideChar>(towlower(c)); 
+  };
+};
+
+template<class Traits = ExactChars>
+class StringIndex
+{
+public:
+  enum { npos = -1 };
+
+  StringIndex() : mCount(0) {};
+
+  /* maps the key to value, replacing whatever the key mapped to before.
+     returns the previous value, or npos if the key is new. values must
+     not be negative. */
+  int insert(const WideChar* key, const size_t length, const int value)
+  {
+    assert(value >= 0);
+    if((mCount + 1) * 2 > mSlots.size())
+      grow();
+
+    unsigned int keyHash = hash(key, length);
+    size_t mask = mSlots.size() - 1;
+    for(size_t i = keyHash & mask; ; i = (i + 1) & mask)
+    {
+      Slot& slot = mSlots[i];
+      if(slot.value == npos)
+      {
+        slot.hash = keyHash;
+        slot.keyOffset = static_cast<unsigned int>(mPool.size());
+        slot.keyLength = static_cast<unsigned int>(length);
+        slot.value = value;
+        for(size_t c = 0; c < length; c++)
+          mPool.push_back(Traits::normalize(key[c]));
+        mCount++;
+        return npos;
+      }
+      if((slot.hash == keyHash) && equals(slot, key, length))
+      {
+        int previous = slot.value;
+        slot.value = value;
+        return previous;
+      }
+    }
+  };
+  int insert(const WideString& key, const int value)
+  {
+    return insert(key.c_str(), key.size(), value);
+  };
+
+  /* returns the value the key maps to, or npos */
+  int find(const WideChar* key, const size_t length) const
+  {
+    if(mCount == 0)
+      return npos;
+
+    unsigned int keyHash = hash(key, length);
+    size_t mask = mSlots.size() - 1;
+    for(size_t i = keyHash & mask; ; i = (i + 1) & mask)
+    {
+      const Slot& slot = mSlots[i];
+      if(slot.value == npos)
+        return npos;
+      if((slot.hash == keyHash) && equals(slot, key, length))
+        return slot.value;
+    }
+  };
+  int find(const WideString& key) const
+  {
+    return find(key.c_str(), key.size());
+  };
+
+  /* sizes the table for the given number of keys, so building
+     a large index does not rehash over and over */
+  void reserve(const size_t count)
+  {
+    size_t capacity = 16;
+    while(capacity < count * 2)
+      capacity <<= 1;
+    if(capacity > mSlots.size())
+      rehash(capacity);
+  };
+
+  void clear()
+  {
+    mSlots.clear();
+    mPool.clear();
+    mCount = 0;
+  };
+
+  size_t size() const
+  {
+    return mCount;
+  };
+
+private:
+  struct Slot
+  {
+    unsigned int hash;
+    unsigned int keyOffset;
+    unsigned int keyLength;
+    int value;
+  };
+
+  std::vector<Slot> mSlots;
+  std::vector<WideChar> mPool;
+  size_t mCount;
+
+  static unsigned int hash(const WideChar* key, const size_t length)
+  {
+    // FNV-1a, on the normalized characters
+    unsigned int result = 2166136261U;
+    for(size_t i = 0; i < length; i++)
+    {
+      result ^= static_cast<unsigned int>(Traits::normalize(key[i]));
+      result *= 16777619U;
+    }
+    return result;
+  };
+
+  bool equals(const Slot& slot, const WideChar* key, const size_t length) const
+  {
+    if(slot.keyLength != length)
+      return false;
+
+    for(size_t i = 0; i < length; i++)
+      if(mPool[slot.keyOffset + i] != Traits::normalize(key[i]))
+        return false;
+
+    return true;
+  };
+
+  void grow()
+  {
+    rehash(mSlots.empty() ? 16 : mSlots.size() * 2);
+  };
+
+  void rehash(const size_t capacity)
+  {
+    Slot empty = { 0, 0, 0, npos };
+    std::vector<Slot> slots(capacity, empty);
+    size_t mask = capacity - 1;
+    for(typename std::vector<Slot>::iterator iter = mSlots.begin(); iter != mSlots.end(); iter++)
+    {
+      if(iter->value == npos)
+        continue;
+
+      size_t i = iter->hash & mask;
+      while(slots[i].value != npos)
+        i = (i + 1) & mask;
+      slots[i] = *iter;
+    }
+    mSlots.swap(slots);
+  };
+};
+
+} /* namespace yaglib */
+
+#endif /* GJ_STRING_INDEX_HEADER */
@@ -38,6 +38,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef GJ_STRING_UTILS_HEADER
 #define GJ_STRING_UTILS_HEADER
 
+#include "GjCharConv.h"
 #include <string>
 #include <utility>
 #include <boost/algorithm/string.hpp>
@@ -209,39 +210,68 @@ template<class StringType> bool parse_bool(const StringType& input, const bool d
     ((input[0] == '1') || (input[0] == 't') || (input[0] == 'T') || (input[0] == 'y') || (input[0] == 'Y'));
 }
 
+// whole strings, see GjCharConv.h.  trailing characters are ignored.
+template<class StringType> CharConvError from_chars(const StringType& input, int& value, const int base = 10)
+{
+  return from_chars(input.data(), input.data() + input.size(), value, base).error;
+}
+
+template<class StringType> CharConvError from_chars(const StringType& input, unsigned int& value, const int base = 10)
+{
+  return from_chars(input.data(), input.data() + input.size(), value, base).error;
+}
+
+template<class StringType> CharConvError from_chars(const StringType& input, double& value)
+{
+  return from_chars(input.data(), input.data() + input.size(), value).error;
+}
+
 template<class StringType> int parse_int(const StringType& input, const int default_value = 0)
 {
   int result = default_value;
-  _stscanf(input.c_str(), L"%d", &result);
+  from_chars(input, result);
   return result;
 }
 
 template<class StringType> double parse_double(const StringType& input, const double default_value = 0.0)
 {
   double result = default_value;
-  _stscanf(input.c_str(), L"%f", &result);
+  from_chars(input, result);
   return result;
 }
 
+// like "%x": an optional sign and 0x, and anything up to 0xFFFFFFFF, 
+// which colors need
 template<class StringType> int parse_hex_int(const StringType& input, const int default_value = 0)
 {
-  int result = default_value;
-  _stscanf(input.c_str(), L"%x", &result);
-  return result;
+  typedef typename StringType::value_type CharType;
+  const CharType* first = input.data();
+  const CharType* last = first + input.size();
+  first = detail::skip_blanks(first, last);
+  bool negative = (first != last) && (*first == '-');
+  if((first != last) && ((*first == '-') || (*first == '+')))
+    first++;
+  if((last - first > 2) && (first[0] == '0') && ((first[1] | 0x20) == 'x') && 
+    (detail::digit_value(first[2]) < 16))
+    first += 2;
+
+  unsigned int result;
+  if(!from_chars(first, last, result, 16).ok())
+    return default_value;
+  return static_cast<int>(negative ? 0 - result : result);
 }
 
 template<class StringType> StringType to_s(const int value)
 {
-  char buf[32];
-  sprintf(buf, "%d", value);
-  return StringType(buf);
+  typename StringType::value_type buf[16];
+  return StringType(buf, to_chars(buf, buf + 16, value).ptr);
 }
 
+// "%f", with room for any double
 template<class StringType> StringType to_s(const double value)
 {
-  char buf[32];
-  sprintf(buf, "%f", value);
-  return StringType(buf);
+  typename StringType::value_type buf[336];
+  return StringType(buf, to_chars(buf, buf + 336, value).ptr);
 }
 
 template<class StringType> StringType to_s(const bool value)
@@ -0,0 +1,174 @@
+/*
+Yet Another Game Library
+Copyright (c) 2001-2007, Virgilio A. Blones, Jr. (vij_blones_jr@yahoo.com)
+See https://sourceforge.net/projects/yaglib/ for the latest updates.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, 
+      this list of conditions and the following disclaimer.
+      
+    * Redistributions in binary form must reproduce the above copyright notice, 
+      this list of conditions and the following disclaimer in the documentation 
+      and/or other materials provided with the distribution.
+      
+    * Neither the name of this library (YAGLib) nor the names of its contributors 
+      may be used to endorse or promote products derived from this software 
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <process.h>
+#include "GjThreads.h"
+using namespace yaglib;
+
+CriticalSection::CriticalSection()
+{
+  InitializeCriticalSection(&mSection);
+}
+
+CriticalSection::~CriticalSection()
+{
+  DeleteCriticalSection(&mSection);
+}
+
+void CriticalSection::enter()
+{
+  EnterCriticalSection(&mSection);
+}
+
+void CriticalSection::leave()
+{
+  LeaveCriticalSection(&mSection);
+}
+
+// WorkerPool
+WorkerPool::WorkerPool(const int workerCount) : 
+  mJobsQueued(NULL), mAllDone(NULL), mOutstanding(0), mStopping(false)
+{
+  int count = workerCount;
+  if(count <= 0)
+  {
+    SYSTEM_INFO si;
+    ZeroMemory(&si, sizeof(SYSTEM_INFO));
+    GetSystemInfo(&si);
+    count = (int)si.dwNumberOfProcessors;
+  }
+
+  mJobsQueued = CreateSemaphore(NULL, 0, 0x7FFFFFFF, NULL);
+  mAllDone = CreateEvent(NULL, TRUE, TRUE, NULL);
+
+  for(int i = 0; i < count; i++)
+  {
+    unsigned threadId = 0;
+    HANDLE hThread = (HANDLE) _beginthreadex(NULL, 0, WorkerThread, (void*) this, 0, &threadId);
+    if(hThread != 0)
+      mThreads.push_back(hThread);
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  stop();
+  CloseHandle(mJobsQueued);
+  CloseHandle(mAllDone);
+}
+
+void WorkerPool::stop()
+{
+  {
+    ScopedLock lock(mLock);
+    mStopping = true;
+    mOutstanding -= mJobs.size();
+    mJobs.clear();
+    if(mOutstanding == 0)
+      SetEvent(mAllDone);
+  }
+
+  // wake everyone up so they notice, then wait for them to leave
+  ReleaseSemaphore(mJobsQueued, (LONG)mThreads.size(), NULL);
+  for(std::vector<HANDLE>::iterator iter = mThreads.begin(); iter != mThreads.end(); iter++)
+  {
+    WaitForSingleObject(*iter, INFINITE);
+    CloseHandle(*iter);
+  }
+  mThreads.clear();
+}
+
+void WorkerPool::submit(const WorkerJob& job)
+{
+  {
+    ScopedLock lock(mLock);
+    if(mStopping)
+      return;
+
+    mJobs.push_back(job);
+    mOutstanding++;
+    ResetEvent(mAllDone);
+  }
+  ReleaseSemaphore(mJobsQueued, 1, NULL);
+}
+
+void WorkerPool::wait()
+{
+  WaitForSingleObject(mAllDone, INFINITE);
+}
+
+int WorkerPool::getWorkerCount() const
+{
+  return (int)mThreads.size();
+}
+
+size_t WorkerPool::getPendingCount()
+{
+  ScopedLock lock(mLock);
+  return mJobs.size();
+}
+
+void WorkerPool::workerLoop()
+{
+  for(;;)
+  {
+    WaitForSingleObject(mJobsQueued, INFINITE);
+
+    WorkerJob job;
+    {
+      ScopedLock lock(mLock);
+      if(mStopping)
+        return;
+      if(mJobs.empty())
+        continue;
+
+      job = mJobs.front();
+      mJobs.pop_front();
+    }
+
+    job();
+
+    ScopedLock lock(mLock);
+    if(--mOutstanding == 0)
+      SetEvent(mAllDone);
+  }
+}
+
+unsigned __stdcall WorkerPool::WorkerThread(LPVOID lParam)
+{
+  WorkerPool* _this = reinterpret_cast<WorkerPool*>(lParam);
+  if(_this != NULL)
+    _this->workerLoop();
+
+  return 0;
+}
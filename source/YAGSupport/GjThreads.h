@@ -0,0 +1,105 @@
+/*
+Yet Another Game Library
+Copyright (c) 2001-2007, Virgilio A. Blones, Jr. (vij_blones_jr@yahoo.com)
+See https://sourceforge.net/projects/yaglib/ for the latest updates.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, 
+      this list of conditions and the following disclaimer.
+      
+    * Redistributions in binary form must reproduce the above copyright notice, 
+      this list of conditions and the following disclaimer in the documentation 
+      and/or other materials provided with the distribution.
+      
+    * Neither the name of this library (YAGLib) nor the names of its contributors 
+      may be used to endorse or promote products derived from this software 
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/** 
+ * @file  GjThreads.h
+ * @brief Threading sundries: locks and a pool of worker threads
+ *
+ */
+#ifndef GJ_THREADS_HEADER
+#define GJ_THREADS_HEADER
+
+#include "GjDefs.h"
+#include <boost/function.hpp>
+#include <boost/utility.hpp>
+
+namespace yaglib 
+{
+
+class CriticalSection : private boost::noncopyable
+{
+public:
+  CriticalSection();
+  ~CriticalSection();
+
+  void enter();
+  void leave();
+
+private:
+  CRITICAL_SECTION mSection;
+};
+
+/* holds the critical section for as long as it's in scope */
+class ScopedLock : private boost::noncopyable
+{
+public:
+  explicit ScopedLock(CriticalSection& section) : mSection(section) { mSection.enter(); };
+  ~ScopedLock() { mSection.leave(); };
+
+private:
+  CriticalSection& mSection;
+};
+
+typedef boost::function<void ()> WorkerJob;
+
+/* runs submitted jobs on a fixed set of threads, in submission order.
+   jobs still queued when the pool is destroyed are discarded; the ones
+   already running are allowed to finish. */
+class WorkerPool : private boost::noncopyable
+{
+public:
+  explicit WorkerPool(const int workerCount = 0);
+  virtual ~WorkerPool();
+
+  void submit(const WorkerJob& job);
+  void wait();
+
+  int getWorkerCount() const;
+  size_t getPendingCount();
+
+private:
+  CriticalSection mLock;
+  std::deque<WorkerJob> mJobs;
+  HANDLE mJobsQueued;     // semaphore, counts the queued jobs
+  HANDLE mAllDone;        // set while nothing is queued or running
+  std::vector<HANDLE> mThreads;
+  size_t mOutstanding;
+  bool mStopping;
+
+  void stop();
+  void workerLoop();
+  static unsigned __stdcall WorkerThread(LPVOID lParam);
+};
+
+} /* namespace yaglib */
+
+#endif /* GJ_THREADS_HEADER */
@@ -6,7 +6,17 @@
 #include "GjVFSEntities.h"
 #include "GjVFSFile.h"
 #include "GjVFSDataHolder.h"
+#include "GjVFSChecksum.h"
+#include "GjVFSDataCache.h"
 #include "GjVFSFolder.h"
+#include "GjVFSMappedFile.h"
+#include "GjVFSFlatToc.h"
 #include "GjVFSVolume.h"
+#include "GjVFSBatchLoad.h"
+#include "GjVFSPrefetch.h"
+#include "GjVFSBuilder.h"
+#include "GjVFSLayeredVolume.h"
+#include "GjVFSFileStream.h"
+#include "GjVFSResourceStore.h"
 
 #endif /* GJ_VFS_HEADER */
@@ -0,0 +1,246 @@
+
+#include "GjVFSBatchLoad.h"
+#include <algorithm>
+using namespace yaglib;
+using namespace yaglib::vfs;
+
+BatchLoader::BatchLoader(const WideString& archiveName) :
+  m_File(INVALID_HANDLE_VALUE), m_ReadCount(0), m_BytesRead(0)
+{
+  m_File = CreateFile(archiveName.c_str(), GENERIC_READ, FILE_SHARE_READ,
+    NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED|FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+}
+
+BatchLoader::~BatchLoader()
+{
+  if(m_File != INVALID_HANDLE_VALUE)
+    CloseHandle(m_File);
+}
+
+const bool BatchLoader::isOpen() const
+{
+  return m_File != INVALID_HANDLE_VALUE;
+}
+
+void BatchLoader::add(File* file)
+{
+  DataHolder* holder = file->getDataHolder();
+  if((holder->getShared() == NULL) && !holder->hasData())
+    m_Holders.push_back(holder);
+}
+
+void BatchLoader::add(Folder* folder, const bool recursive)
+{
+  Files* files = folder->getFiles();
+  for(Entities::iterator iter = files->begin(); iter != files->end(); iter++)
+    add(dynamic_cast<File*>(*iter));
+
+  if(!recursive)
+    return;
+
+  Folders* folders = folder->getFolders();
+  for(Entities::iterator iter = folders->begin(); iter != folders->end(); iter++)
+    add(dynamic_cast<Folder*>(*iter), recursive);
+}
+
+const int BatchLoader::getFileCount() const
+{
+  return (int)m_Holders.size();
+}
+
+const int BatchLoader::getReadCount() const
+{
+  return m_ReadCount;
+}
+
+const double BatchLoader::getBytesRead() const
+{
+  return m_BytesRead;
+}
+
+static bool byOffset(DataHolder* a, DataHolder* b)
+{
+  return a->getOffset() < b->getOffset();
+}
+
+void BatchLoader::plan(std::vector<Range>& ranges)
+{
+  std::sort(m_Holders.begin(), m_Holders.end(), byOffset);
+
+  for(size_t i = 0; i < m_Holders.size(); i++)
+  {
+    DataHolder* holder = m_Holders[i];
+    FileOffset start = holder->getOffset();
+    FileOffset end = start + (FileOffset)holder->getStoredSize();
+
+    // close enough to the last range, and not making it too big
+    if(!ranges.empty())
+    {
+      Range& last = ranges.back();
+      FileOffset lastEnd = last.offset + (FileOffset)last.size;
+      if((start >= last.offset) && (start <= lastEnd + (FileOffset)cDefBatchGap) &&
+         (end - last.offset <= (FileOffset)cDefBatchRangeSize))
+      {
+        if(end > lastEnd)
+          last.size = (size_t)(end - last.offset);
+        last.count++;
+        continue;
+      }
+    }
+
+    Range range;
+    range.offset = start;
+    range.size = (size_t)(end - start);
+    range.first = i;
+    range.count = 1;
+    ranges.push_back(range);
+  }
+}
+
+int BatchLoader::deliver(const Range& range, PByte& buffer)
+{
+  int loaded = 0;
+  for(size_t i = range.first; i < range.first + range.count; i++)
+  {
+    DataHolder* holder = m_Holders[i];
+    size_t within = (size_t)(holder->getOffset() - range.offset);
+    size_t size = holder->getStoredSize();
+
+    // a range holding just the one file hands its buffer over as is
+    PByte stored;
+    if((range.count == 1) && (within == 0) && (size == range.size))
+    {
+      stored = buffer;
+      buffer = NULL;
+    }
+    else
+    {
+      stored = new Byte [size];
+      memcpy(stored, buffer + within, size);
+    }
+
+    if(holder->unpack(stored, true))
+      loaded++;
+  }
+
+  return loaded;
+}
+
+struct BatchRead
+{
+  OVERLAPPED overlapped;
+  HANDLE event;
+  PByte buffer;
+  int range;    // -1 when the slot is free
+};
+
+int BatchLoader::load()
+{
+  m_ReadCount = 0;
+  m_BytesRead = 0;
+  if((m_File == INVALID_HANDLE_VALUE) || m_Holders.empty())
+    return 0;
+
+  std::vector<Range> ranges;
+  plan(ranges);
+
+  BatchRead reads[cDefBatchReadsInFlight];
+  for(int i = 0; i < cDefBatchReadsInFlight; i++)
+  {
+    reads[i].event = CreateEvent(NULL, TRUE, FALSE, NULL);
+    reads[i].buffer = NULL;
+    reads[i].range = -1;
+  }
+
+  int loaded = 0;
+  int active = 0;
+  size_t next = 0;
+  while((next < ranges.size()) || (active > 0))
+  {
+    // keep as many reads going as we're allowed
+    for(int i = 0; (i < cDefBatchReadsInFlight) && (next < ranges.size()); i++)
+    {
+      if(reads[i].range >= 0)
+        continue;
+
+      Range& range = ranges[next];
+      BatchRead& read = reads[i];
+      ZeroMemory(&read.overlapped, sizeof(OVERLAPPED));
+      read.overlapped.Offset = (DWORD)(range.offset & 0xFFFFFFFF);
+      read.overlapped.OffsetHigh = (DWORD)(range.offset >> 32);
+      read.overlapped.hEvent = read.event;
+      ResetEvent(read.event);
+      read.buffer = new Byte [range.size];
+      read.range = (int)next++;
+
+      if(range.size == 0)
+      {
+        // nothing to read, empty files are done right away
+        loaded += deliver(range, read.buffer);
+        delete [] read.buffer;
+        read.range = -1;
+        continue;
+      }
+
+      if(!ReadFile(m_File, read.buffer, (DWORD)range.size, NULL, &read.overlapped) &&
+         (GetLastError() != ERROR_IO_PENDING))
+      {
+        delete [] read.buffer;
+        read.range = -1;
+        continue;
+      }
+
+      m_ReadCount++;
+      active++;
+    }
+
+    if(active == 0)
+      continue;
+
+    // whichever finishes first
+    HANDLE events[cDefBatchReadsInFlight];
+    int slots[cDefBatchReadsInFlight];
+    int waiting = 0;
+    for(int i = 0; i < cDefBatchReadsInFlight; i++)
+      if(reads[i].range >= 0)
+      {
+        events[waiting] = reads[i].event;
+        slots[waiting++] = i;
+      }
+
+    DWORD signalled = WaitForMultipleObjects(waiting, events, FALSE, INFINITE) - WAIT_OBJECT_0;
+    if(signalled >= (DWORD)waiting)
+      break;
+
+    BatchRead& read = reads[slots[signalled]];
+    Range& range = ranges[read.range];
+    DWORD bytesRead = 0;
+    if(GetOverlappedResult(m_File, &read.overlapped, &bytesRead, FALSE) && (bytesRead == range.size))
+    {
+      m_BytesRead += bytesRead;
+      loaded += deliver(range, read.buffer);
+    }
+
+    delete [] read.buffer;
+    read.buffer = NULL;
+    read.range = -1;
+    active--;
+  }
+
+  // only if waiting failed is anything still going. it must not land
+  // in buffers we no longer have.
+  for(int i = 0; i < cDefBatchReadsInFlight; i++)
+  {
+    if(reads[i].range >= 0)
+    {
+      CancelIo(m_File);
+      DWORD bytesRead;
+      GetOverlappedResult(m_File, &reads[i].overlapped, &bytesRead, TRUE);
+      delete [] reads[i].buffer;
+    }
+    CloseHandle(reads[i].event);
+  }
+
+  m_Holders.clear();
+  return loaded;
+}
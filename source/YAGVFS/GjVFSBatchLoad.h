@@ -0,0 +1,79 @@
+
+#ifndef GJ_VFS_BATCH_LOAD_HEADER
+#define GJ_VFS_BATCH_LOAD_HEADER
+
+#include "GjDefs.h"
+#include "GjVFSDefs.h"
+#include "GjVFSFile.h"
+#include "GjVFSFolder.h"
+#include "GjVFSDataHolder.h"
+
+#include <vector>
+#include <boost/utility.hpp>
+
+namespace yaglib
+{
+  namespace vfs
+  {
+
+// ranges closer than this are read as one, gap and all
+const size_t cDefBatchGap = 65536;
+// but a single read never grows past this
+const size_t cDefBatchRangeSize = 4 * 1024 * 1024;
+// how many reads are kept in flight at once
+const int cDefBatchReadsInFlight = 8;
+
+/**
+ * loads the data of many files of one archive in a single go.  the
+ * files are sorted by where their data is in the archive, neighbours
+ * are merged into larger reads, and those are all issued as overlapped
+ * reads, several in flight at once, so the disk sees one mostly
+ * sequential stream of requests instead of a seek and read per file.
+ *
+ * files that are already loaded, or share another file's data, are
+ * skipped.  the files' holders must be set up to load from the archive
+ * (see DataHolder::assign) and must not be read by anyone until load()
+ * returns.
+ */
+class BatchLoader : private boost::noncopyable
+{
+public:
+  BatchLoader(const WideString& archiveName);
+  ~BatchLoader();
+
+  const bool isOpen() const;
+
+  void add(File* file);
+  void add(Folder* folder, const bool recursive = true);
+  const int getFileCount() const;
+
+  // issues the reads and waits for all of them. returns how many files
+  // were loaded; the rest are left as they were.
+  int load();
+
+  // what the last load() took
+  const int getReadCount() const;
+  const double getBytesRead() const;
+
+private:
+  struct Range
+  {
+    FileOffset offset;
+    size_t size;
+    size_t first;   // into m_Holders, once sorted
+    size_t count;
+  };
+
+  HANDLE m_File;
+  std::vector<DataHolder*> m_Holders;
+  int m_ReadCount;
+  double m_BytesRead;
+
+  void plan(std::vector<Range>& ranges);
+  int deliver(const Range& range, PByte& buffer);
+};
+
+  } /* namespace vfs */
+} /* namespace yaglib */
+
+#endif /* GJ_VFS_BATCH_LOAD_HEADER */
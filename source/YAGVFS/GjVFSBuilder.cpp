@@ -0,0 +1,352 @@
+
+#include "GjVFSBuilder.h"
+#include "GjVFSCodec.h"
+#include "GjVFSChecksum.h"
+#include "GjUnicodeUtils.h"
+#include "GjBFS.h"
+#include <algorithm>
+#include <fstream>
+#include <boost/bind.hpp>
+using namespace yaglib;
+using namespace yaglib::vfs;
+
+// how many files each worker may have read ahead of the writer
+static const int cReadAheadPerWorker = 4;
+
+// 64-bit FNV-1a, only used to find candidates. matches are compared in full.
+static unsigned long long hashBytes(const Byte* data, size_t size)
+{
+  unsigned long long hash = 14695981039346656037ULL;
+  for(size_t i = 0; i < size; i++)
+  {
+    hash ^= data[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+static bool readSourceFile(const WideString& fileName, std::vector<Byte>& data)
+{
+  UTF8String utf8FileName(fileName);
+  std::ifstream source(utf8FileName.c_str(), std::ios::in|std::ios::binary);
+  if(!source.is_open())
+    return false;
+
+  source.seekg(0, std::ios::end);
+  std::streamoff length = source.tellg();
+  source.seekg(0, std::ios::beg);
+  if(length < 0)
+    return false;
+
+  data.resize((size_t)length);
+  if(length > 0)
+    source.read((char*)&data[0], length);
+  return !source.fail();
+}
+
+ArchiveBuilder::ArchiveBuilder(const int workerCount) :
+  m_WorkerCount(workerCount), m_Codec(cCodecNone), m_Deduplicate(true),
+  m_RawBytes(0), m_StoredBytes(0), m_DuplicateCount(0), m_SavedBytes(0),
+  m_ItemDone(NULL)
+{
+  m_ItemDone = CreateEvent(NULL, FALSE, FALSE, NULL);
+}
+
+ArchiveBuilder::~ArchiveBuilder()
+{
+  CloseHandle(m_ItemDone);
+}
+
+void ArchiveBuilder::setCodec(const int codec)
+{
+  m_Codec = codec;
+}
+
+const int ArchiveBuilder::getCodec() const
+{
+  return m_Codec;
+}
+
+void ArchiveBuilder::setDeduplicate(const bool deduplicate)
+{
+  m_Deduplicate = deduplicate;
+}
+
+const bool ArchiveBuilder::getDeduplicate() const
+{
+  return m_Deduplicate;
+}
+
+File* ArchiveBuilder::add(const WideString& path, const WideString& sourceFile)
+{
+  WideString target(path);
+  File* file = m_Volume.getFile(target, true);
+  if(file == NULL)
+    return NULL;
+
+  file->setCodec(m_Codec);
+  m_Sources[file] = sourceFile;
+  return file;
+}
+
+int ArchiveBuilder::addFolder(const WideString& path, const WideString& sourceFolder)
+{
+  // directory listings come back in no particular order, sort them
+  // so the same tree always builds the same archive
+  WideString prefix = path;
+  if(!prefix.empty() && (prefix[prefix.size()-1] != PATH_SEPARATOR[0]))
+    prefix += PATH_SEPARATOR;
+
+  int count = 0;
+  std::vector<WideString> list;
+  bfs::list_files(sourceFolder, list, true, false);
+  std::sort(list.begin(), list.end());
+  for(std::vector<WideString>::iterator iter = list.begin(); iter != list.end(); iter++)
+    if(add(prefix + *iter, sourceFolder + L"\\" + *iter) != NULL)
+      count++;
+
+  list.clear();
+  bfs::list_files(sourceFolder, list, false, true);
+  std::sort(list.begin(), list.end());
+  for(std::vector<WideString>::iterator iter = list.begin(); iter != list.end(); iter++)
+    count += addFolder(prefix + *iter, sourceFolder + L"\\" + *iter);
+
+  return count;
+}
+
+File* ArchiveBuilder::addWhiteout(const WideString& path)
+{
+  // an empty entry, named after the last part of the path
+  size_t nameStart = path.find_last_of(L"/\\");
+  nameStart = (nameStart == WideString::npos) ? 0 : nameStart + 1;
+  WideString target = path.substr(0, nameStart) + WHITEOUT_PREFIX + path.substr(nameStart);
+  return add(target, L"");
+}
+
+bool ArchiveBuilder::build(const WideString& archiveName)
+{
+  m_RawBytes = 0;
+  m_StoredBytes = 0;
+  m_DuplicateCount = 0;
+  m_SavedBytes = 0;
+  m_Items.clear();
+  collectFiles(&m_Volume);
+
+  UTF8String utf8(archiveName);
+  std::ofstream dest(utf8.c_str(), std::ios::binary|std::ios::out);
+  if(!dest.is_open()) return false;
+
+  // the structures only depend on the names, so the room they need is
+  // known up front. reserve it, stream the data in after it, and fill
+  // the header and structures in once every stored size is known.
+  VFS_HEADER vfsHeader;
+  memset(&vfsHeader, 0, sizeof(VFS_HEADER));
+  strcpy(vfsHeader.signature, cDefSignature);
+  vfsHeader.version = cCurrentVersion;
+  vfsHeader.headerSize = sizeof(VFS_HEADER);
+  vfsHeader.folderOffset = vfsHeader.headerSize;
+  vfsHeader.alignment = cBlobAlignment;
+  vfsHeader.dataOffset = (int)alignOffset(FlatToc::measure(&m_Volume) + vfsHeader.headerSize, cBlobAlignment);
+
+  std::vector<char> reserved(vfsHeader.dataOffset, 0);
+  dest.write(&reserved[0], (std::streamsize)reserved.size());
+
+  // identical files are found by reading back what was written
+  WrittenBlobs written;
+  std::ifstream check;
+  if(m_Deduplicate)
+    check.open(utf8.c_str(), std::ios::binary|std::ios::in);
+
+  bool built = true;
+  {
+    // declared after the items it works on, so it's gone (and its
+    // threads joined) before they are
+    WorkerPool pool(m_WorkerCount);
+    size_t readAhead = (size_t)(pool.getWorkerCount() * cReadAheadPerWorker);
+    size_t submitted = 0;
+    for(; (submitted < m_Items.size()) && (submitted < readAhead); submitted++)
+      pool.submit(boost::bind(&ArchiveBuilder::readItem, this, &m_Items[submitted]));
+
+    for(size_t i = 0; i < m_Items.size(); i++)
+    {
+      BuildItem* item = waitForItem(i);
+      if(item->failed)
+      {
+        built = false;
+        break;
+      }
+
+      m_RawBytes += item->dataSize;
+      FileOffset sharedOffset;
+      if(m_Deduplicate && findWritten(item, written, dest, check, sharedOffset))
+      {
+        item->file->setPrepared(item->dataSize, item->data.size(), item->codec,
+          item->checksum, sharedOffset);
+        m_DuplicateCount++;
+        m_SavedBytes += item->data.size();
+      }
+      else
+      {
+        File::alignData(dest);
+        WrittenBlob blob;
+        blob.offset = (FileOffset)dest.tellp();
+        blob.storedSize = item->data.size();
+        blob.dataSize = item->dataSize;
+        blob.codec = item->codec;
+        if(m_Deduplicate && !item->data.empty())
+          written.insert(WrittenBlobs::value_type(item->hash, blob));
+
+        if(!item->data.empty())
+          dest.write((char*)&item->data[0], (std::streamsize)item->data.size());
+        item->file->setPrepared(item->dataSize, item->data.size(), item->codec,
+          item->checksum);
+        m_StoredBytes += item->data.size();
+      }
+      std::vector<Byte>().swap(item->data);
+
+      if(submitted < m_Items.size())
+      {
+        pool.submit(boost::bind(&ArchiveBuilder::readItem, this, &m_Items[submitted]));
+        submitted++;
+      }
+    }
+  }
+
+  if(built)
+  {
+    dest.seekp(0, std::ios::beg);
+    dest.write((char*) &vfsHeader, sizeof(VFS_HEADER));
+    FlatToc::write(dest, &m_Volume, vfsHeader.dataOffset);
+  }
+
+  m_Items.clear();
+  return built && dest.good();
+}
+
+void ArchiveBuilder::collectFiles(Folder* folder)
+{
+  // same order the table and saveData() walk the tree in
+  Folders* folders = folder->getFolders();
+  for(Entities::iterator iter = folders->begin(); iter != folders->end(); iter++)
+    collectFiles(dynamic_cast<Folder*>(*iter));
+
+  Files* files = folder->getFiles();
+  for(Entities::iterator iter = files->begin(); iter != files->end(); iter++)
+  {
+    BuildItem item;
+    item.file = dynamic_cast<File*>(*iter);
+    item.source = m_Sources[item.file];
+    item.dataSize = 0;
+    item.codec = cCodecNone;
+    item.hash = 0;
+    item.checksum = 0;
+    item.ready = false;
+    item.failed = false;
+    m_Items.push_back(item);
+  }
+}
+
+void ArchiveBuilder::readItem(BuildItem* item)
+{
+  // runs on the workers. only this item is touched until it's ready.
+  std::vector<Byte> data;
+  bool loaded = item->source.empty() || readSourceFile(item->source, data);
+  int codec = cCodecNone;
+
+  if(loaded && !data.empty() && (item->file->getCodec() != cCodecNone))
+  {
+    std::vector<Byte> packed;
+    if(codec::compress(&data[0], data.size(), packed))
+    {
+      item->dataSize = data.size();
+      data.swap(packed);
+      codec = item->file->getCodec();
+    }
+  }
+  if(codec == cCodecNone)
+    item->dataSize = data.size();
+
+  item->data.swap(data);
+  item->codec = codec;
+  item->hash = item->data.empty() ? 0 : hashBytes(&item->data[0], item->data.size());
+  item->checksum = item->data.empty() ? 0 : checksum::crc32c(&item->data[0], item->data.size());
+  item->failed = !loaded;
+
+  ScopedLock lock(m_Lock);
+  item->ready = true;
+  SetEvent(m_ItemDone);
+}
+
+ArchiveBuilder::BuildItem* ArchiveBuilder::waitForItem(const size_t index)
+{
+  BuildItem* item = &m_Items[index];
+  for(;;)
+  {
+    {
+      ScopedLock lock(m_Lock);
+      if(item->ready)
+        return item;
+    }
+    WaitForSingleObject(m_ItemDone, INFINITE);
+  }
+}
+
+bool ArchiveBuilder::findWritten(BuildItem* item, WrittenBlobs& written,
+  std::ofstream& dest, std::ifstream& check, FileOffset& offset)
+{
+  if(item->data.empty())
+    return false;
+
+  std::pair<WrittenBlobs::iterator, WrittenBlobs::iterator> range = written.equal_range(item->hash);
+  if(range.first == range.second)
+    return false;
+
+  // read the candidates back from what we've written so far, so a
+  // hash collision can never make two different files share data
+  dest.flush();
+  std::vector<Byte> existing(item->data.size());
+
+  for(WrittenBlobs::iterator iter = range.first; iter != range.second; iter++)
+  {
+    WrittenBlob& blob = iter->second;
+    if((blob.storedSize != item->data.size()) || (blob.dataSize != item->dataSize) ||
+       (blob.codec != item->codec))
+      continue;
+
+    check.clear();
+    check.seekg(blob.offset, std::ios::beg);
+    check.read((char*)&existing[0], (std::streamsize)existing.size());
+    if(check.good() && (memcmp(&existing[0], &item->data[0], existing.size()) == 0))
+    {
+      offset = blob.offset;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+const int ArchiveBuilder::getFileCount() const
+{
+  return (int)m_Sources.size();
+}
+
+const double ArchiveBuilder::getRawBytes() const
+{
+  return m_RawBytes;
+}
+
+const double ArchiveBuilder::getStoredBytes() const
+{
+  return m_StoredBytes;
+}
+
+const int ArchiveBuilder::getDuplicateCount() const
+{
+  return m_DuplicateCount;
+}
+
+const double ArchiveBuilder::getSavedBytes() const
+{
+  return m_SavedBytes;
+}
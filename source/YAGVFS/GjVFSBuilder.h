@@ -0,0 +1,105 @@
+
+#ifndef GJ_VFS_BUILDER_HEADER
+#define GJ_VFS_BUILDER_HEADER
+
+#include "GjDefs.h"
+#include "GjVFSDefs.h"
+#include "GjVFSFile.h"
+#include "GjVFSVolume.h"
+#include "GjThreads.h"
+
+#include <map>
+
+namespace yaglib
+{
+  namespace vfs
+  {
+
+/**
+ * builds an archive straight from files on disk.  nothing is read when
+ * files are added; build() reads (and compresses) them on a pool of
+ * worker threads while a single writer streams the results out in tree
+ * order.  the output is the same whatever the number of threads.
+ *
+ * files with the same content are stored once, with all their entries
+ * pointing at it.  with that turned off, the output is exactly what
+ * ReadWriteVolume::saveToFile() would write for the same tree.
+ */
+class ArchiveBuilder : private boost::noncopyable
+{
+public:
+  ArchiveBuilder(const int workerCount = 0);
+  virtual ~ArchiveBuilder();
+
+  // the codec new files are stored with
+  void setCodec(const int codec);
+  const int getCodec() const;
+
+  void setDeduplicate(const bool deduplicate);
+  const bool getDeduplicate() const;
+
+  File* add(const WideString& path, const WideString& sourceFile);
+  // adds a folder tree, in name order, under path. returns the file count
+  int addFolder(const WideString& path, const WideString& sourceFolder);
+  // for patch archives: deletes path from the layers below
+  File* addWhiteout(const WideString& path);
+
+  bool build(const WideString& archiveName);
+
+  const int getFileCount() const;
+  const double getRawBytes() const;
+  const double getStoredBytes() const;
+  // files that were stored as references to identical ones, and the
+  // bytes that saved
+  const int getDuplicateCount() const;
+  const double getSavedBytes() const;
+
+private:
+  struct BuildItem
+  {
+    File* file;
+    WideString source;
+    std::vector<Byte> data;
+    size_t dataSize;
+    int codec;
+    unsigned long long hash;  // of the stored form
+    unsigned int checksum;    // ditto, what the table records
+    bool ready;
+    bool failed;
+  };
+  typedef std::vector<BuildItem> BuildItems;
+
+  struct WrittenBlob
+  {
+    FileOffset offset;
+    size_t storedSize;
+    size_t dataSize;
+    int codec;
+  };
+  typedef std::multimap<unsigned long long, WrittenBlob> WrittenBlobs;
+
+  ReadWriteVolume m_Volume;
+  std::map<File*, WideString> m_Sources;
+  int m_WorkerCount;
+  int m_Codec;
+  bool m_Deduplicate;
+  double m_RawBytes;
+  double m_StoredBytes;
+  int m_DuplicateCount;
+  double m_SavedBytes;
+
+  BuildItems m_Items;
+  CriticalSection m_Lock;
+  HANDLE m_ItemDone;
+
+  void collectFiles(Folder* folder);
+  void readItem(BuildItem* item);
+  BuildItem* waitForItem(const size_t index);
+  bool findWritten(BuildItem* item, WrittenBlobs& written, std::ofstream& dest,
+    std::ifstream& check, FileOffset& offset);
+};
+
+  } /* namespace vfs */
+} /* namespace yaglib */
+
+#endif /* GJ_VFS_BUILDER_HEADER */
@@ -0,0 +1,106 @@
+
+#include "GjVFSChecksum.h"
+#if defined(_M_IX86) || defined(_M_X64)
+#include <intrin.h>
+#include <nmmintrin.h>
+#define HAS_CRC_INSTRUCTION
+#endif
+using namespace yaglib;
+using namespace yaglib::vfs;
+
+// the reflected Castagnoli polynomial
+#define CRC32C_POLYNOMIAL 0x82F63B78U
+
+static unsigned int sTable[8][256];
+static bool sHardware = false;
+
+// built once, before anything can ask for a checksum
+static struct Crc32cSetup
+{
+  Crc32cSetup()
+  {
+    for(unsigned int i = 0; i < 256; i++)
+    {
+      unsigned int crc = i;
+      for(int bit = 0; bit < 8; bit++)
+        crc = (crc & 1) ? ((crc >> 1) ^ CRC32C_POLYNOMIAL) : (crc >> 1);
+      sTable[0][i] = crc;
+    }
+
+    // sTable[k] is a byte's effect k bytes further down the data
+    for(int k = 1; k < 8; k++)
+      for(int i = 0; i < 256; i++)
+        sTable[k][i] = (sTable[k - 1][i] >> 8) ^ sTable[0][sTable[k - 1][i] & 0xFF];
+
+#ifdef HAS_CRC_INSTRUCTION
+    int info[4];
+    __cpuid(info, 1);
+    sHardware = (info[2] & (1 << 20)) != 0;
+#endif
+  }
+} sSetup;
+
+#ifdef HAS_CRC_INSTRUCTION
+static unsigned int crc32cHardware(const Byte* data, size_t size, unsigned int crc)
+{
+  crc = ~crc;
+  while((size > 0) && ((size_t)data & 7))
+  {
+    crc = _mm_crc32_u8(crc, *data++);
+    size--;
+  }
+
+#ifdef _M_X64
+  unsigned long long crc64 = crc;
+  for(; size >= 8; size -= 8, data += 8)
+    crc64 = _mm_crc32_u64(crc64, *(const unsigned long long*)data);
+  crc = (unsigned int)crc64;
+#else
+  for(; size >= 4; size -= 4, data += 4)
+    crc = _mm_crc32_u32(crc, *(const unsigned int*)data);
+#endif
+
+  for(; size > 0; size--)
+    crc = _mm_crc32_u8(crc, *data++);
+  return ~crc;
+}
+#endif
+
+unsigned int checksum::crc32cPortable(const Byte* data, size_t size, unsigned int crc)
+{
+  crc = ~crc;
+  while((size > 0) && ((size_t)data & 3))
+  {
+    crc = sTable[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    size--;
+  }
+
+  // eight bytes a step. x86 is little endian, which this relies on
+  for(; size >= 8; size -= 8, data += 8)
+  {
+    unsigned int one = *(const unsigned int*)data ^ crc;
+    unsigned int two = *(const unsigned int*)(data + 4);
+    crc = sTable[7][one & 0xFF] ^ sTable[6][(one >> 8) & 0xFF] ^
+          sTable[5][(one >> 16) & 0xFF] ^ sTable[4][one >> 24] ^
+          sTable[3][two & 0xFF] ^ sTable[2][(two >> 8) & 0xFF] ^
+          sTable[1][(two >> 16) & 0xFF] ^ sTable[0][two >> 24];
+  }
+
+  for(; size > 0; size--)
+    crc = sTable[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+unsigned int checksum::crc32c(const Byte* data, size_t size, unsigned int crc)
+{
+#ifdef HAS_CRC_INSTRUCTION
+  if(sHardware)
+    return crc32cHardware(data, size, crc);
+#endif
+  return crc32cPortable(data, size, crc);
+}
+
+bool checksum::hasHardwareSupport()
+{
+  return sHardware;
+}
@@ -0,0 +1,34 @@
+
+#ifndef GJ_VFS_CHECKSUM_HEADER
+#define GJ_VFS_CHECKSUM_HEADER
+
+#include "GjDefs.h"
+
+namespace yaglib
+{
+  namespace vfs
+  {
+
+/**
+ * blobs are checksummed with CRC-32C (Castagnoli), which SSE4.2 computes
+ * in hardware at several bytes per cycle.  without it, a slicing-by-8
+ * table version is used, which gives the same results.
+ */
+namespace checksum
+{
+  /* the checksum of size bytes. pass a previous result as crc to
+     continue it over the next piece of the data. */
+  unsigned int crc32c(const Byte* data, size_t size, unsigned int crc = 0);
+
+  /* the same, but never using the hardware. mostly for benchmarks */
+  unsigned int crc32cPortable(const Byte* data, size_t size, unsigned int crc = 0);
+
+  /* true if crc32c() runs on the SSE4.2 instruction */
+  bool hasHardwareSupport();
+
+} /* namespace checksum */
+
+  } /* namespace vfs */
+} /* namespace yaglib */
+
+#endif /* GJ_VFS_CHECKSUM_HEADER */
@@ -0,0 +1,251 @@
+
+#include "GjVFSCodec.h"
+using namespace yaglib;
+using namespace yaglib::vfs;
+
+#define HASH_BITS     12
+#define MIN_MATCH     4
+#define MAX_OFFSET    65535
+
+static inline unsigned int read32(const Byte* p)
+{
+  unsigned int value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static inline unsigned int hash4(const Byte* p)
+{
+  return (read32(p) * 2654435761U) >> (32 - HASH_BITS);
+}
+
+static inline Byte* writeLength(Byte* op, size_t length)
+{
+  // lengths past the 4-bit token field continue in 255-sized steps
+  while(length >= 255)
+  {
+    *op++ = 255;
+    length -= 255;
+  }
+  *op++ = (Byte) length;
+  return op;
+}
+
+// returns the packed size, or 0 if the block does not fit in capacity
+static size_t compressBlock(const Byte* source, size_t size, Byte* dest, size_t capacity)
+{
+  int table[1 << HASH_BITS];
+  for(int i = 0; i < (1 << HASH_BITS); i++)
+    table[i] = -1;
+
+  const Byte* ip = source;
+  const Byte* anchor = source;
+  const Byte* end = source + size;
+  Byte* op = dest;
+  Byte* opEnd = dest + capacity;
+
+  while((end - ip) >= MIN_MATCH)
+  {
+    unsigned int h = hash4(ip);
+    int candidate = table[h];
+    table[h] = (int)(ip - source);
+
+    const Byte* ref = source + candidate;
+    if((candidate < 0) || ((ip - ref) > MAX_OFFSET) || (read32(ref) != read32(ip)))
+    {
+      ip++;
+      continue;
+    }
+
+    size_t matchLength = MIN_MATCH;
+    while((ip + matchLength < end) && (ref[matchLength] == ip[matchLength]))
+      matchLength++;
+
+    // token, extra lengths, literals, then the 16-bit offset
+    size_t literals = ip - anchor;
+    size_t worstCase = 1 + (literals / 255) + 1 + literals + 2 + (matchLength / 255) + 1;
+    if(worstCase > (size_t)(opEnd - op))
+      return 0;
+
+    size_t matchCode = matchLength - MIN_MATCH;
+    Byte* token = op++;
+    *token = (Byte)(((literals < 15) ? literals : 15) << 4);
+    if(literals >= 15)
+      op = writeLength(op, literals - 15);
+    memcpy(op, anchor, literals);
+    op += literals;
+
+    size_t offset = ip - ref;
+    *op++ = (Byte)(offset & 0xFF);
+    *op++ = (Byte)(offset >> 8);
+
+    *token |= (Byte)((matchCode < 15) ? matchCode : 15);
+    if(matchCode >= 15)
+      op = writeLength(op, matchCode - 15);
+
+    ip += matchLength;
+    anchor = ip;
+  }
+
+  // the last sequence is literals only, the decoder stops after them
+  size_t literals = end - anchor;
+  if((1 + (literals / 255) + 1 + literals) > (size_t)(opEnd - op))
+    return 0;
+
+  Byte* token = op++;
+  *token = (Byte)(((literals < 15) ? literals : 15) << 4);
+  if(literals >= 15)
+    op = writeLength(op, literals - 15);
+  memcpy(op, anchor, literals);
+  op += literals;
+
+  return op - dest;
+}
+
+bool codec::decompressBlock(const Byte* source, size_t sourceSize, Byte* dest, size_t destSize)
+{
+  const Byte* ip = source;
+  const Byte* ipEnd = source + sourceSize;
+  Byte* op = dest;
+  Byte* opEnd = dest + destSize;
+
+  while(ip < ipEnd)
+  {
+    unsigned int token = *ip++;
+
+    size_t literals = token >> 4;
+    if(literals == 15)
+    {
+      Byte extra;
+      do
+      {
+        if(ip >= ipEnd) return false;
+        extra = *ip++;
+        literals += extra;
+      } while(extra == 255);
+    }
+
+    if((literals > (size_t)(ipEnd - ip)) || (literals > (size_t)(opEnd - op)))
+      return false;
+    memcpy(op, ip, literals);
+    ip += literals;
+    op += literals;
+
+    if(ip == ipEnd)
+      break;
+
+    if((ipEnd - ip) < 2)
+      return false;
+    size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if((offset == 0) || (offset > (size_t)(op - dest)))
+      return false;
+
+    size_t matchLength = (token & 15);
+    if(matchLength == 15)
+    {
+      Byte extra;
+      do
+      {
+        if(ip >= ipEnd) return false;
+        extra = *ip++;
+        matchLength += extra;
+      } while(extra == 255);
+    }
+    matchLength += MIN_MATCH;
+
+    if(matchLength > (size_t)(opEnd - op))
+      return false;
+
+    // matches may overlap what they are writing, so go byte by byte
+    // unless the source is far enough behind
+    const Byte* ref = op - offset;
+    if(offset >= matchLength)
+      memcpy(op, ref, matchLength);
+    else
+      for(size_t i = 0; i < matchLength; i++)
+        op[i] = ref[i];
+    op += matchLength;
+  }
+
+  return op == opEnd;
+}
+
+bool codec::compress(const Byte* source, size_t size, std::vector<Byte>& dest)
+{
+  dest.clear();
+  if(size == 0)
+    return false;
+
+  // no point going past the original size, that blob would be stored raw
+  dest.resize(size);
+  size_t used = 0;
+  for(size_t done = 0; done < size; done += cCodecBlockSize)
+  {
+    size_t blockSize = ((size - done) < cCodecBlockSize) ? (size - done) : cCodecBlockSize;
+    if(used + sizeof(unsigned int) >= size)
+    {
+      dest.clear();
+      return false;
+    }
+
+    Byte* header = &dest[used];
+    used += sizeof(unsigned int);
+
+    size_t room = size - used;
+    size_t packed = compressBlock(source + done, blockSize, &dest[used], room);
+    unsigned int headerValue;
+    if((packed == 0) || (packed >= blockSize))
+    {
+      if(blockSize >= room)
+      {
+        dest.clear();
+        return false;
+      }
+      memcpy(&dest[used], source + done, blockSize);
+      packed = blockSize;
+      headerValue = (unsigned int)packed | cCodecStoredBlock;
+    }
+    else
+      headerValue = (unsigned int)packed;
+
+    memcpy(header, &headerValue, sizeof(headerValue));
+    used += packed;
+  }
+
+  dest.resize(used);
+  return true;
+}
+
+bool codec::decompress(const Byte* source, size_t sourceSize, Byte* dest, size_t destSize)
+{
+  size_t ip = 0;
+  size_t done = 0;
+  while(done < destSize)
+  {
+    if((sourceSize - ip) < sizeof(unsigned int))
+      return false;
+
+    unsigned int header = read32(source + ip);
+    ip += sizeof(unsigned int);
+
+    size_t packed = header & ~cCodecStoredBlock;
+    size_t blockSize = ((destSize - done) < cCodecBlockSize) ? (destSize - done) : cCodecBlockSize;
+    if(packed > (sourceSize - ip))
+      return false;
+
+    if(header & cCodecStoredBlock)
+    {
+      if(packed != blockSize)
+        return false;
+      memcpy(dest + done, source + ip, blockSize);
+    }
+    else if(!decompressBlock(source + ip, packed, dest + done, blockSize))
+      return false;
+
+    ip += packed;
+    done += blockSize;
+  }
+
+  return ip == sourceSize;
+}
@@ -0,0 +1,41 @@
+
+#ifndef GJ_VFS_CODEC_HEADER
+#define GJ_VFS_CODEC_HEADER
+
+#include "GjDefs.h"
+#include "GjVFSDefs.h"
+
+namespace yaglib
+{
+  namespace vfs
+  {
+
+/**
+ * the built-in codec is a small LZ77 variant (byte oriented, 64k window,
+ * LZ4-style sequences) which trades ratio for decode speed.  a packed
+ * blob is a run of independent blocks, each holding up to cCodecBlockSize
+ * bytes of the original data.  every block starts with a 32-bit header:
+ * the low 31 bits are the packed length that follows, and the top bit is
+ * set when the block is stored as-is because it would not compress.
+ */
+const size_t cCodecBlockSize = 65536;
+const unsigned int cCodecStoredBlock = 0x80000000U;
+
+namespace codec
+{
+  /* compresses size bytes from source into dest. returns false, leaving
+     dest empty, if the result would not be smaller than the original. */
+  bool compress(const Byte* source, size_t size, std::vector<Byte>& dest);
+
+  /* unpacks a whole blob, which must expand to exactly destSize bytes */
+  bool decompress(const Byte* source, size_t sourceSize, Byte* dest, size_t destSize);
+
+  /* unpacks a single block's payload (without its header) */
+  bool decompressBlock(const Byte* source, size_t sourceSize, Byte* dest, size_t destSize);
+
+} /* namespace codec */
+
+  } /* namespace vfs */
+} /* namespace yaglib */
+
+#endif /* GJ_VFS_CODEC_HEADER */
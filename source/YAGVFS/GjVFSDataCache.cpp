@@ -0,0 +1,249 @@
+
+#include "GjVFSDataCache.h"
+#include "GjVFSDataHolder.h"
+using namespace yaglib;
+using namespace yaglib::vfs;
+
+DataCache::DataCache(const size_t budget) :
+  m_Budget(budget), m_Resident(0), m_ResidentCount(0),
+  m_Newest(NULL), m_Oldest(NULL), m_Hits(0), m_Misses(0), m_Evictions(0),
+  m_RetiredBytes(0)
+{
+}
+
+DataCache::~DataCache()
+{
+  // let go of whatever we track. the payloads stay with their holders.
+  ScopedLock lock(m_Lock);
+  while(m_Oldest != NULL)
+  {
+    DataHolder* holder = m_Oldest;
+    unlink(holder);
+    holder->m_Cache = NULL;
+  }
+  freeRetired();
+}
+
+void DataCache::setBudget(const size_t budget)
+{
+  ScopedLock lock(m_Lock);
+  m_Budget = budget;
+  evict(m_Budget);
+}
+
+const size_t DataCache::getBudget() const
+{
+  return m_Budget;
+}
+
+const size_t DataCache::getResidentBytes() const
+{
+  return m_Resident;
+}
+
+const int DataCache::getResidentCount() const
+{
+  return m_ResidentCount;
+}
+
+PByte DataCache::acquire(DataHolder* holder)
+{
+  // pin first, so the load can't evict what it just brought in
+  pin(holder);
+  return holder->getPinnedData();
+}
+
+void DataCache::release(DataHolder* holder)
+{
+  unpin(holder);
+}
+
+void DataCache::pin(DataHolder* holder)
+{
+  // shared data is tracked on the holder that owns it
+  if(holder->m_Primary != NULL)
+    holder = holder->m_Primary;
+
+  ScopedLock lock(m_Lock);
+  holder->m_Pins++;
+}
+
+void DataCache::unpin(DataHolder* holder)
+{
+  if(holder->m_Primary != NULL)
+    holder = holder->m_Primary;
+
+  ScopedLock lock(m_Lock);
+  if(holder->m_Pins > 0)
+    holder->m_Pins--;
+
+  // whatever went over the budget while this was pinned can go now
+  if((holder->m_Pins == 0) && (m_Resident > m_Budget))
+    evict(m_Budget);
+}
+
+void DataCache::trim()
+{
+  ScopedLock lock(m_Lock);
+  evict(m_Budget);
+}
+
+void DataCache::flush()
+{
+  ScopedLock lock(m_Lock);
+  evict(0);
+}
+
+void DataCache::reclaim()
+{
+  ScopedLock lock(m_Lock);
+  freeRetired();
+}
+
+const size_t DataCache::getRetiredBytes() const
+{
+  return m_RetiredBytes;
+}
+
+const long DataCache::getHits() const
+{
+  return m_Hits;
+}
+
+const long DataCache::getMisses() const
+{
+  return m_Misses;
+}
+
+const long DataCache::getEvictions() const
+{
+  return m_Evictions;
+}
+
+void DataCache::resetCounters()
+{
+  InterlockedExchange(&m_Hits, 0);
+  InterlockedExchange(&m_Misses, 0);
+  InterlockedExchange(&m_Evictions, 0);
+}
+
+void DataCache::accessed(DataHolder* holder, const bool hit)
+{
+  InterlockedIncrement(hit ? &m_Hits : &m_Misses);
+
+  // data we didn't load ourselves isn't ours to manage
+  if(!holder->m_OwnsData)
+    return;
+
+  ScopedLock lock(m_Lock);
+  if(holder->m_Cached)
+  {
+    // already tracked, just make it the most recent
+    if(holder != m_Newest)
+    {
+      unlink(holder);
+      link(holder);
+    }
+    return;
+  }
+
+  // someone may have dropped it in the meantime, and whatever
+  // can't be loaded again must never be evicted
+  if((holder->m_Data == NULL) || !holder->canReload())
+    return;
+
+  link(holder);
+  if(m_Resident > m_Budget)
+    evict(m_Budget);
+}
+
+void DataCache::dropped(DataHolder* holder)
+{
+  ScopedLock lock(m_Lock);
+  if(holder->m_Cached)
+    unlink(holder);
+}
+
+void DataCache::detach(DataHolder* holder)
+{
+  ScopedLock lock(m_Lock);
+  if(holder->m_Cached)
+    unlink(holder);
+  holder->m_Pins = 0;
+}
+
+void DataCache::link(DataHolder* holder)
+{
+  holder->m_Older = m_Newest;
+  holder->m_Newer = NULL;
+  if(m_Newest != NULL)
+    m_Newest->m_Newer = holder;
+  else
+    m_Oldest = holder;
+  m_Newest = holder;
+
+  holder->m_Cached = true;
+  m_Resident += holder->m_DataSize;
+  m_ResidentCount++;
+}
+
+void DataCache::unlink(DataHolder* holder)
+{
+  if(holder->m_Newer != NULL)
+    holder->m_Newer->m_Older = holder->m_Older;
+  else
+    m_Newest = holder->m_Older;
+
+  if(holder->m_Older != NULL)
+    holder->m_Older->m_Newer = holder->m_Newer;
+  else
+    m_Oldest = holder->m_Newer;
+
+  holder->m_Newer = NULL;
+  holder->m_Older = NULL;
+  holder->m_Cached = false;
+  m_Resident -= holder->m_DataSize;
+  m_ResidentCount--;
+}
+
+void DataCache::evict(const size_t budget)
+{
+  // oldest first, stepping over anything pinned
+  DataHolder* holder = m_Oldest;
+  while((holder != NULL) && (m_Resident > budget))
+  {
+    DataHolder* newer = holder->m_Newer;
+    if(holder->m_Pins == 0)
+    {
+      // only owned data gets linked, so it's ours to free. unless
+      // someone got it without a pin since it was loaded, then it waits
+      // for reclaim(). the flag is looked at both before and after
+      // m_Data is cleared, see DataHolder::load().
+      unlink(holder);
+      LONG readUnpinned = InterlockedExchange(&holder->m_ReadUnpinned, 0);
+      PByte data = (PByte) InterlockedExchangePointer(
+        (PVOID volatile*) &holder->m_Data, NULL);
+      readUnpinned |= holder->m_ReadUnpinned;
+      if(data != NULL)
+      {
+        if(readUnpinned != 0)
+        {
+          m_Retired.push_back(data);
+          m_RetiredBytes += holder->m_DataSize;
+        }
+        else
+          delete [] data;
+      }
+      InterlockedIncrement(&m_Evictions);
+    }
+    holder = newer;
+  }
+}
+
+void DataCache::freeRetired()
+{
+  for(std::vector<PByte>::iterator iter = m_Retired.begin(); iter != m_Retired.end(); iter++)
+    delete [] *iter;
+  m_Retired.clear();
+  m_RetiredBytes = 0;
+}
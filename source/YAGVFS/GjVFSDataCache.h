@@ -0,0 +1,100 @@
+
+#ifndef GJ_VFS_DATA_CACHE_HEADER
+#define GJ_VFS_DATA_CACHE_HEADER
+
+#include "GjDefs.h"
+#include "GjVFSDefs.h"
+#include "GjThreads.h"
+#include <vector>
+
+namespace yaglib
+{
+  namespace vfs
+  {
+
+class DataHolder;
+
+/**
+ * keeps the loaded payloads of a volume under a byte budget.  data
+ * holders attached to the cache report every getData() to it; payloads
+ * the holder owns and can load again are tracked in recency order, and
+ * the least recently used ones are dropped once the budget is exceeded.
+ * payloads that can't be reloaded (mapped, or assigned by hand) are
+ * never evicted and don't count against the budget.
+ *
+ * acquire()/release() (or pin()/unpin() around getPinnedData()) keep
+ * data in place for as long as it's needed.  holders also read through
+ * plain getData() may still be evicted, but if they were since their
+ * data was loaded it's only retired, not freed, so those pointers stay
+ * good until reclaim().  call it where no unpinned pointers are held,
+ * e.g. between frames; the resource manager does so for the volumes it
+ * serves from.  the cache must outlive every holder attached to it, or
+ * be detached from them first.
+ */
+class DataCache : private boost::noncopyable
+{
+public:
+  DataCache(const size_t budget);
+  virtual ~DataCache();
+
+  void setBudget(const size_t budget);
+  const size_t getBudget() const;
+  const size_t getResidentBytes() const;
+  const int getResidentCount() const;
+
+  // pins the holder, then loads its data. pair with release()
+  PByte acquire(DataHolder* holder);
+  void release(DataHolder* holder);
+
+  // pinned holders are never evicted. pins nest.
+  void pin(DataHolder* holder);
+  void unpin(DataHolder* holder);
+
+  // evicts until we are back under the budget
+  void trim();
+  // evicts everything that isn't pinned
+  void flush();
+  // frees the payloads evicted from under unpinned readers
+  void reclaim();
+  const size_t getRetiredBytes() const;
+
+  const long getHits() const;
+  const long getMisses() const;
+  const long getEvictions() const;
+  void resetCounters();
+
+private:
+  friend class DataHolder;
+
+  CriticalSection m_Lock;
+  size_t m_Budget;
+  size_t m_Resident;
+  int m_ResidentCount;
+
+  // most recently used first
+  DataHolder* m_Newest;
+  DataHolder* m_Oldest;
+
+  volatile LONG m_Hits;
+  volatile LONG m_Misses;
+  volatile LONG m_Evictions;
+
+  // evicted, but maybe still being read
+  std::vector<PByte> m_Retired;
+  size_t m_RetiredBytes;
+
+  // called by the holders
+  void accessed(DataHolder* holder, const bool hit);
+  void dropped(DataHolder* holder);
+  void detach(DataHolder* holder);
+
+  void link(DataHolder* holder);
+  void unlink(DataHolder* holder);
+  void evict(const size_t budget);
+  void freeRetired();
+};
+
+  } /* namespace vfs */
+} /* namespace yaglib */
+
+#endif /* GJ_VFS_DATA_CACHE_HEADER */
@@ -1,13 +1,24 @@
 
 #include "GjVFSDataHolder.h"
+#include "GjVFSCodec.h"
+#include "GjVFSChecksum.h"
 #include "GjUnicodeUtils.h"
 #include <fstream>
 using namespace yaglib;
 using namespace yaglib::vfs;
 
+// where a holder's stored data stands with its checksum
+const LONG cCheckOff = 0;       // not checked when loaded
+const LONG cCheckPending = 1;   // will be, the first time
+const LONG cCheckPassed = 2;
+const LONG cCheckFailed = 3;
+
 DataHolder::DataHolder(DemandLoader* demandLoader) :
   m_DemandLoader(demandLoader), m_Data(NULL), m_DataSize(0),
-  m_Offset(0)
+  m_OwnsData(false), m_Offset(0), m_StoredSize(0), m_Codec(cCodecNone),
+  m_Stored(NULL), m_Primary(NULL), m_HasChecksum(false), m_Checksum(0),
+  m_Check(cCheckOff), m_Cache(NULL), m_Newer(NULL), m_Older(NULL),
+  m_Cached(false), m_Pins(0), m_ReadUnpinned(0)
 {
   // basic setup, has demand loader, but no data.
   // there's no data descriptor either (size, offset).
@@ -17,7 +28,11 @@ DataHolder::DataHolder(DemandLoader* demandLoader) :
 }
 
 DataHolder::DataHolder(PByte data, size_t size, bool ownsData) :
-  m_DemandLoader(NULL), m_Data(NULL), m_DataSize(0), m_Offset(0)
+  m_DemandLoader(NULL), m_Data(NULL), m_DataSize(0), m_OwnsData(false),
+  m_Offset(0), m_StoredSize(0), m_Codec(cCodecNone), m_Stored(NULL),
+  m_Primary(NULL), m_HasChecksum(false), m_Checksum(0), m_Check(cCheckOff),
+  m_Cache(NULL), m_Newer(NULL), m_Older(NULL), m_Cached(false), m_Pins(0),
+  m_ReadUnpinned(0)
 {
   // standalone setup. demand-loading will not be supported
   // because a demand-loader was not passed in.
@@ -27,6 +42,8 @@ DataHolder::DataHolder(PByte data, size_t size, bool ownsData) :
 void DataHolder::assign(PByte data, size_t size, bool ownsData)
 {
   dropData();
+  forgetStored();
+  m_Primary = NULL;
   if((data == NULL) || (size == 0)) 
     return;
 
@@ -34,7 +51,7 @@ void DataHolder::assign(PByte data, size_t size, bool ownsData)
   {
     // we're not supposed to own the passed buffer, so let's make 
     // our buffer and copy it there
-    m_Data = new Byte [m_DataSize];
+    m_Data = new Byte [size];
     memcpy(m_Data, data, size);
   }
   else
@@ -57,15 +74,26 @@ void DataHolder::assign(PByte source, int offset, size_t size, bool ownsData)
   assign(data, size, ownsData);
 }
 
-void DataHolder::assign(int offset, size_t size)
+void DataHolder::assign(FileOffset offset, size_t size)
+{
+  assign(offset, size, size, cCodecNone);
+}
+
+void DataHolder::assign(FileOffset offset, size_t storedSize, size_t size, int codec)
 {
   // ignore this call if there is no demand loader to begin with
   if(m_DemandLoader == NULL)
     return;
 
   dropData();
+  m_Primary = NULL;
   m_DataSize = size;
   m_Offset = offset;
+  m_StoredSize = storedSize;
+  m_Codec = codec;
+  m_Stored = NULL;
+  m_HasChecksum = false;
+  m_Check = cCheckOff;
 }
 
 void DataHolder::assign(WideString& fileName)
@@ -85,6 +113,8 @@ void DataHolder::assign(WideString& fileName)
 
     // get rid of the old data first, if it's there...
     dropData();
+    forgetStored();
+    m_Primary = NULL;
 
     m_OwnsData = true;
     m_DataSize = length;
@@ -92,8 +122,126 @@ void DataHolder::assign(WideString& fileName)
   }
 }
 
+void DataHolder::reference(PByte data, size_t size)
+{
+  // point straight at someone else's memory, e.g. a mapped volume.
+  // the buffer must outlive us, and we never free it.
+  dropData();
+  m_Primary = NULL;
+  m_Data = data;
+  m_DataSize = size;
+  m_OwnsData = false;
+}
+
+void DataHolder::referenceStored(PByte stored)
+{
+  // the stored form (as described by assign()) is directly visible,
+  // e.g. in a mapped volume. unpacked data can point right at it,
+  // anything packed gets expanded on demand.
+  m_Stored = stored;
+  if(m_Codec == cCodecNone)
+    reference(stored, m_StoredSize);
+}
+
+bool DataHolder::unpack(PByte stored, bool ownsStored)
+{
+  dropData();
+  m_Primary = NULL;
+
+  if(!check(stored))
+  {
+    if(ownsStored)
+      delete [] stored;
+    return false;
+  }
+
+  bool owned;
+  PByte data = expand(stored, ownsStored, owned);
+  return (data != NULL) && (loaded(data, owned) != NULL);
+}
+
+void DataHolder::shareWith(DataHolder* primary)
+{
+  if(primary == NULL)
+    return;
+  while(primary->m_Primary != NULL)
+    primary = primary->m_Primary;
+  if(primary == this)
+    return;
+
+  dropData();
+  m_Data = NULL;
+  m_Primary = primary;
+}
+
+DataHolder* DataHolder::getShared() const
+{
+  return m_Primary;
+}
+
+PByte DataHolder::expand(PByte stored, bool ownsStored, bool& owned)
+{
+  // turns the stored form into the actual data, without touching
+  // any of our state. several threads may be doing this at once.
+  if(stored == NULL)
+    return NULL;
+
+  if(m_Codec == cCodecNone)
+  {
+    owned = ownsStored;
+    return stored;
+  }
+
+  PByte data = new Byte [m_DataSize];
+  bool unpacked = (m_Codec == cCodecLZ) &&
+    codec::decompress(stored, m_StoredSize, data, m_DataSize);
+
+  if(ownsStored)
+    delete [] stored;
+
+  if(!unpacked)
+  {
+    delete [] data;
+    return NULL;
+  }
+
+  owned = true;
+  return data;
+}
+
+PByte DataHolder::publish(PByte data, bool owned)
+{
+  // whoever gets here first wins. everyone else (e.g. a prefetch thread
+  // racing the game thread) throws their copy away and uses the winner's.
+  // ownership is the same whoever wins, so setting it early is fine.
+  m_OwnsData = owned;
+  PByte current = (PByte) InterlockedCompareExchangePointer(
+    (PVOID volatile*) &m_Data, data, NULL);
+  if(current == NULL)
+    return data;
+
+  if(owned && (current != data))
+    delete [] data;
+  return current;
+}
+
+void DataHolder::forgetStored()
+{
+  // the data no longer comes from the archive, so reloading
+  // it from there would bring back the wrong thing
+  m_Offset = 0;
+  m_StoredSize = 0;
+  m_Codec = cCodecNone;
+  m_Stored = NULL;
+  m_HasChecksum = false;
+  m_Check = cCheckOff;
+}
+
 void DataHolder::dropData()
 {
+  if(m_Cached && (m_Cache != NULL))
+    m_Cache->dropped(this);
+
   if((m_Data != NULL) && (m_OwnsData))
   {
     delete [] m_Data;
@@ -103,9 +251,72 @@ void DataHolder::dropData()
 
 const PByte DataHolder::getData()
 {
-  // return immediately if we do have the data
-  if(m_Data != NULL)
-    return m_Data;
+  return load(false);
+}
+
+const PByte DataHolder::getPinnedData()
+{
+  return load(true);
+}
+
+PByte DataHolder::load(const bool pinned)
+{
+  if(m_Primary != NULL)
+    return m_Primary->load(pinned);
+
+  for(;;)
+  {
+    bool hit;
+    PByte data = fetch(hit);
+    if(data == NULL)
+      return NULL;
+
+    // the cache can't tell when an unpinned reader is done, so it must
+    // not free what we hand out here until it's been loaded again. the
+    // flag goes up once we have the data, and eviction takes it down
+    // before clearing m_Data and looks again after, so if m_Data is
+    // still ours below, its eviction is bound to see the flag. if it's
+    // gone already it may be freed, and we start over.
+    if(!pinned)
+    {
+      if(m_ReadUnpinned == 0)
+        InterlockedExchange(&m_ReadUnpinned, 1);
+      if(m_Data != data)
+        continue;
+    }
+
+    if(m_Cache != NULL)
+      m_Cache->accessed(this, hit);
+    return data;
+  }
+}
+
+PByte DataHolder::fetch(bool& hit)
+{
+  // once bad, always bad
+  if(m_Check == cCheckFailed)
+    return NULL;
+
+  // return immediately if we do have the data. if it's referenced
+  // straight from the archive, as stored, it may not be checked yet.
+  PByte data = m_Data;
+  hit = (data != NULL);
+  if(hit)
+  {
+    if((m_Check == cCheckPending) && (data == m_Stored) && !check(data))
+      return NULL;
+    return data;
+  }
+
+  // the stored data may be right there, just packed
+  bool owned;
+  if(m_Stored != NULL)
+  {
+    if(!check(m_Stored))
+      return NULL;
+    data = expand(m_Stored, false, owned);
+    return (data != NULL) ? publish(data, owned) : NULL;
+  }
 
   // we don't have any data! check if we can perform demand-loading...
   if(m_DemandLoader == NULL)
@@ -114,20 +325,31 @@ const PByte DataHolder::getData()
   // perform demand-loading, if this fails, return NULL
   // demand-loading MUST return a unique data buffer that 
   // we WILL own, and cleanup later.
-  PByte temp = m_DemandLoader->Load(m_Offset, m_DataSize);
+  PByte temp = m_DemandLoader->Load(m_Offset, m_StoredSize);
   if(temp == NULL)
     return NULL;
+  if(!check(temp))
+  {
+    delete [] temp;
+    return NULL;
+  }
 
-  // success! remember this data pointer for next time...
-  m_Data = temp;
-  m_OwnsData = true;
+  // success! remember this data (unpacked) for next time...
+  data = expand(temp, true, owned);
+  return (data != NULL) ? publish(data, owned) : NULL;
+}
 
-  // should now have data to return
-  return m_Data;
+PByte DataHolder::loaded(PByte data, bool owned)
+{
+  data = publish(data, owned);
+  if(m_Cache != NULL)
+    m_Cache->accessed(this, false);
+  return data;
 }
 
 DataHolder::~DataHolder() 
 { 
+  setCache(NULL);
   dropData(); 
 }
 
@@ -136,7 +358,17 @@ const size_t DataHolder::getDataSize() const
   return m_DataSize; 
 }
 
-const int DataHolder::getOffset() const 
+const size_t DataHolder::getStoredSize() const
+{
+  return m_StoredSize;
+}
+
+const int DataHolder::getCodec() const
+{
+  return m_Codec;
+}
+
+const FileOffset DataHolder::getOffset() const 
 { 
   return m_Offset; 
 }
@@ -158,6 +390,115 @@ const bool DataHolder::isDataOwned() const
 
 const bool DataHolder::hasData() const 
 { 
-  return (m_Data != NULL); 
+  return (m_Primary != NULL) ? m_Primary->hasData() : (m_Data != NULL); 
+}
+
+
+bool DataHolder::readStored(size_t position, size_t size, PByte dest)
+{
+  if((position > m_StoredSize) || (size > m_StoredSize - position))
+    return false;
+
+  if(m_Stored != NULL)
+  {
+    memcpy(dest, m_Stored + position, size);
+    return true;
+  }
+
+  return (m_DemandLoader != NULL) &&
+    m_DemandLoader->Read(m_Offset + (FileOffset)position, size, dest);
+}
+
+const bool DataHolder::canReload() const
+{
+  if(m_Stored != NULL)
+    return true;
+
+  return (m_DemandLoader != NULL) && (m_StoredSize > 0) &&
+    m_DemandLoader->CanLoad();
 }
 
+void DataHolder::setCache(DataCache* cache)
+{
+  if(cache == m_Cache)
+    return;
+
+  if(m_Cache != NULL)
+    m_Cache->detach(this);
+  m_Cache = cache;
+}
+
+DataCache* DataHolder::getCache() const
+{
+  return m_Cache;
+}
+
+void DataHolder::setChecksum(const unsigned int checksum, const bool verify)
+{
+  m_HasChecksum = true;
+  m_Checksum = checksum;
+  m_Check = verify ? cCheckPending : cCheckOff;
+}
+
+void DataHolder::setVerify(const bool verify)
+{
+  // whatever was found already stays that way
+  if(m_HasChecksum && ((m_Check == cCheckOff) || (m_Check == cCheckPending)))
+    m_Check = verify ? cCheckPending : cCheckOff;
+}
+
+const bool DataHolder::hasChecksum() const
+{
+  return m_HasChecksum;
+}
+
+const unsigned int DataHolder::getChecksum() const
+{
+  return m_Checksum;
+}
+
+const bool DataHolder::hasFailedCheck() const
+{
+  return m_Check == cCheckFailed;
+}
+
+bool DataHolder::verify()
+{
+  if(!m_HasChecksum || (m_Check == cCheckPassed))
+    return true;
+  if(m_Check == cCheckFailed)
+    return false;
+
+  // the stored form, wherever it is
+  PByte stored = m_Stored;
+  bool owned = false;
+  if((stored == NULL) && (m_StoredSize > 0))
+  {
+    if(m_DemandLoader != NULL)
+      stored = m_DemandLoader->Load(m_Offset, m_StoredSize);
+    if(stored == NULL)
+      return false;
+    owned = true;
+  }
+
+  m_Check = cCheckPending;
+  bool good = check(stored);
+  if(owned)
+    delete [] stored;
+  return good;
+}
+
+bool DataHolder::check(const Byte* stored)
+{
+  // each blob is checked at most once. threads racing to load it may
+  // both check it, which is harmless, they can only agree.
+  LONG state = m_Check;
+  if(state != cCheckPending)
+    return state != cCheckFailed;
+
+  bool good = (stored != NULL) || (m_StoredSize == 0);
+  if(good)
+    good = (checksum::crc32c(stored, m_StoredSize) == m_Checksum);
+  InterlockedExchange(&m_Check, good ? cCheckPassed : cCheckFailed);
+  return good;
+}
@@ -5,12 +5,32 @@
 #include "GjDefs.h"
 #include "GjVFSDefs.h"
 #include "GjVFSEntities.h"
+#include "GjVFSDataCache.h"
 
 namespace yaglib
 {
   namespace vfs
   {
 
+/**
+ * holds a file's data, loading (and unpacking) it on demand.  getData()
+ * may be called from several threads at once: the first to finish
+ * loading publishes the data, the others discard theirs.  everything
+ * else (assign, dropData, ...) must not race with readers.
+ *
+ * when attached to a DataCache, loaded data may be dropped again once
+ * it goes cold; see DataCache for how to keep it around.  data handed
+ * out through getData() without a pin since it was last loaded is
+ * retired rather than freed when it's evicted, getPinnedData() is for
+ * callers holding one.
+ *
+ * holders of entries sharing the same stored data can be linked with
+ * shareWith(), and then all go through the first one's data.
+ *
+ * with a checksum set and verification on, the stored data is checked
+ * the first time it is loaded, and the result kept.  data that fails
+ * the check is never handed out; getData() returns NULL for it.
+ */
 class DataHolder
 {
 public:
@@ -20,27 +40,88 @@ public:
 
   void assign(PByte data, size_t, bool ownsData);
   void assign(PByte source, int offset, size_t size, bool ownsData);
-  void assign(int offset, size_t size);
+  void assign(FileOffset offset, size_t size);
+  void assign(FileOffset offset, size_t storedSize, size_t size, int codec);
   void assign(WideString& fileName);
+  void reference(PByte data, size_t size);
+  void referenceStored(PByte stored);
+  bool unpack(PByte stored, bool ownsStored);
+
+  // from now on, use primary's data instead of loading our own. any
+  // of the assign()s, reference() or unpack() ends this.
+  void shareWith(DataHolder* primary);
+  DataHolder* getShared() const;
 
   void dropData();
 
   const PByte getData();
+  // same, for callers that have pinned the holder with its cache
+  const PByte getPinnedData();
   const size_t getDataSize() const;
-  const int getOffset() const;
+  const size_t getStoredSize() const;
+  const int getCodec() const;
+  const FileOffset getOffset() const;
   const DemandLoader* getDemandLoader() const;
   const bool canLoadOnDemand() const;
   const bool isDataOwned() const;
   const bool hasData() const;
 
+  // reads part of the stored (possibly packed) form, without loading
+  // the rest of it. position is relative to the start of the data.
+  bool readStored(size_t position, size_t size, PByte dest);
+
+  // true if the data can be dropped and loaded again later
+  const bool canReload() const;
+
+  void setCache(DataCache* cache);
+  DataCache* getCache() const;
+
+  // the CRC-32C of the stored form, as recorded in the archive. it's
+  // forgotten along with where the data is stored.
+  void setChecksum(const unsigned int checksum, const bool verify);
+  void setVerify(const bool verify);
+  const bool hasChecksum() const;
+  const unsigned int getChecksum() const;
+
+  // checks the stored data now, whether verifying on load or not. true
+  // if it's good, or if there is nothing to check it against.
+  bool verify();
+  const bool hasFailedCheck() const;
+
 private:
+  friend class DataCache;
+
   DemandLoader* m_DemandLoader;
   
-  PByte m_Data;       // this here's our actual data
+  volatile PByte m_Data; // this here's our actual data
   size_t m_DataSize;  // and this tells how much we have
   bool m_OwnsData;    // if this is true, we own the data, and should clean it up
 
-  int m_Offset;       // if to be demand-loaded, this is the offset 
+  FileOffset m_Offset;  // if to be demand-loaded, this is the offset
+  size_t m_StoredSize;// how much is stored there, differs if packed
+  int m_Codec;        // how the stored data is packed
+  PByte m_Stored;     // stored data we can see directly, but don't own
+  DataHolder* m_Primary;  // holder whose data we share, if any
+
+  bool m_HasChecksum;
+  unsigned int m_Checksum;
+  volatile LONG m_Check;  // see cCheckOff and friends in the .cpp
+
+  // cache bookkeeping, guarded by the cache's lock
+  DataCache* m_Cache;
+  DataHolder* m_Newer;
+  DataHolder* m_Older;
+  bool m_Cached;
+  int m_Pins;
+  volatile LONG m_ReadUnpinned; // read without a pin since it was loaded
+
+  PByte load(const bool pinned);
+  PByte fetch(bool& hit);
+  PByte expand(PByte stored, bool ownsStored, bool& owned);
+  PByte publish(PByte data, bool owned);
+  PByte loaded(PByte data, bool owned);
+  bool check(const Byte* stored);
+  void forgetStored();
 
 };
 
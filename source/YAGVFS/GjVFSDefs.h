@@ -11,6 +11,13 @@ namespace yaglib
 
 #define PATH_SEPARATOR  L"/"
 
+// a patch archive deletes an entry of the layers below it with an
+// empty file of the same name carrying this prefix (as overlayfs does)
+#define WHITEOUT_PREFIX L".wh."
+
+// offsets and sizes within an archive
+typedef long long FileOffset;
+
 // Header
 const char cDefSignature[] = "GJ!VFS!";
 typedef struct 
@@ -19,8 +26,75 @@ typedef struct
   int headerSize;
   int folderOffset;
   int dataOffset;
+  int version;        // not in the original format, see cOriginalHeaderSize
+  int alignment;      // cVersionLarge on: every blob starts on a multiple of this
+  int flags;          // cVersionLarge on: reserved, always 0 for now
 } VFS_HEADER, *PVFS_HEADER;
 
+// the original header stops right before the version field. archives
+// with a header this short are cVersionOriginal. the ones that stop
+// right after it are cVersionCompressed.
+const int cOriginalHeaderSize = 20;
+const int cCompressedHeaderSize = 24;
+
+// format versions
+const int cVersionOriginal = 0;
+const int cVersionCompressed = 1;   // file entries add a codec id and the unpacked size
+const int cVersionLarge = 2;        // 64-bit offsets and sizes, aligned blobs
+const int cVersionFlatToc = 3;      // the structures are a single flat table
+const int cCurrentVersion = cVersionFlatToc;
+
+// blobs are page aligned, so they can be mapped or read unbuffered
+const int cBlobAlignment = 4096;
+
+inline FileOffset alignOffset(const FileOffset offset, const int alignment)
+{
+  return ((offset + alignment - 1) / alignment) * alignment;
+}
+
+// cVersionFlatToc on, the header's folderOffset points at this, followed
+// by entryCount entries (entrySize bytes apart) and then the name pool.
+// entry 0 is the root, and the children of each folder are consecutive
+// entries sorted by name. readers don't search it as is: the first
+// lookup hashes every entry's full path into an index, and from then on
+// a path is a single probe (see FlatToc::find).
+typedef struct
+{
+  int entryCount;
+  int entrySize;      // later versions may add fields to the entries
+  int namePoolSize;
+  int flags;          // see cTocChecksums
+} VFS_TOC_HEADER;
+
+typedef struct
+{
+  int nameOffset;     // into the name pool. names are UTF-8, 0 terminated
+  int nameLength;     // in bytes, without the terminator
+  int parent;         // entry index, -1 for the root
+  int flags;          // see cTocFolder
+  int firstChild;     // folders: children are firstChild ...
+  int childCount;     //   ... up to firstChild + childCount - 1
+  FileOffset offset;  // files: where the data is stored
+  FileOffset storedSize;
+  FileOffset dataSize;
+  int codec;
+  int shares;         // files: the entry this one shares data with, or -1
+  unsigned int checksum;  // with cTocChecksums: CRC-32C of the stored data
+  int reserved;
+} VFS_TOC_ENTRY;
+
+// entry flags
+const int cTocFolder = 1;
+
+// table flags. tables written before checksums were added have entries
+// that stop right before the checksum (see cTocBaseEntrySize).
+const int cTocChecksums = 1;
+const int cTocBaseEntrySize = 56;
+
+// codec ids, stored per file entry
+const int cCodecNone = 0;
+const int cCodecLZ = 1;
+
   } /* namespace vfs */
 } /* namespace yaglib */
 
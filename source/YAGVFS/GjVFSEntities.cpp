@@ -7,6 +7,7 @@ using namespace yaglib::vfs;
 Entity::Entity(const WideString& name, Entities* container) :
   m_Name(name), m_Container(container), m_QualifiedName(L"")
 {
+  assembleQualifiedName();
 }
 
 Entity::~Entity()
@@ -16,11 +17,8 @@ Entity::~Entity()
     m_Container->detach(this);
 }
 
-const WideString& Entity::getQualifiedName()
+const WideString& Entity::getQualifiedName() const
 {
-  if(m_QualifiedName.length() == 0)
-    assembleQualifiedName();
-
   return m_QualifiedName;
 }
 
@@ -45,7 +43,7 @@ void Entity::assembleQualifiedName()
   }
 }
 
-PByte Entity::Load(int offset, size_t size)
+PByte Entity::Load(FileOffset offset, size_t size)
 {
   Entity* owner = const_cast<Entity*>(getOwner());
   if(owner != NULL)
@@ -54,11 +52,32 @@ PByte Entity::Load(int offset, size_t size)
   return NULL;
 }
 
+bool Entity::Read(FileOffset offset, size_t size, PByte dest)
+{
+  Entity* owner = const_cast<Entity*>(getOwner());
+  return (owner != NULL) && owner->Read(offset, size, dest);
+}
+
+bool Entity::CanLoad()
+{
+  Entity* owner = const_cast<Entity*>(getOwner());
+  return (owner != NULL) && owner->CanLoad();
+}
+
 const Entity* Entity::getOwner() const
 {
   return (m_Container != NULL) ? m_Container->getOwner() : NULL;
 };
 
+void Entity::prepareData()
+{
+  // the default entity does not have any data
+}
+
+void Entity::releasePreparedData()
+{
+}
+
 int Entity::getIdSize()
 {
   // the default size will be the length of our name, and the size of an int
@@ -67,7 +86,7 @@ int Entity::getIdSize()
   return utf8.c_len() + sizeof(int) + 1;
 }
 
-void Entity::saveId(std::ofstream& dest, int& offset)
+void Entity::saveId(std::ofstream& dest, FileOffset& offset)
 {
   int length = 0;
   if(m_Name.size() > 0)
@@ -86,7 +105,7 @@ void Entity::saveId(std::ofstream& dest, int& offset)
   }
 }
 
-Entity* Entity::loadId(std::ifstream& source)
+Entity* Entity::loadId(std::istream& source, const int version)
 {
   int length;
 
@@ -97,7 +116,7 @@ Entity* Entity::loadId(std::ifstream& source)
     source.read(data, length);
 
     UTF8String utf8(data);
-    utf8.ToWideString(m_Name);
+    m_Name = utf8.asWideString();
 
     delete [] data;
   }
@@ -185,6 +204,13 @@ void Entities::attach(Entity* entity)
   }
 }
 
+void Entities::append(Entity* entity)
+{
+  m_Items.push_back(entity);
+  entity->m_Container = this;
+  entity->containerChanged();
+}
+
 void Entities::detach(Entity* entity, bool free)
 {
   detach(getIndex(entity), free);
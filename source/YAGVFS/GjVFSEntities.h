@@ -20,7 +20,11 @@ class Entity;
 class DemandLoader
 {
 public:
-  virtual PByte Load(int offset, size_t size) = 0;
+  virtual PByte Load(FileOffset offset, size_t size) = 0;
+  // same, but into a buffer the caller provides
+  virtual bool Read(FileOffset offset, size_t size, PByte dest) = 0;
+  // true while Load() can actually be served
+  virtual bool CanLoad() = 0;
 };
 
 class Entity : public DemandLoader
@@ -33,19 +37,26 @@ public:
   const Entity* getOwner() const;
 
   const WideString& getName() const;
-  const WideString& getQualifiedName();
+  // kept up to date as the entity is named and moved, so reading it
+  // never writes anything
+  const WideString& getQualifiedName() const;
 
   void setName(const WideString& newName);
   const virtual bool isFolder() const;
 
   virtual void assembleQualifiedName();
   // supports demand-loading...
-  virtual PByte Load(int offset, size_t size);
-
-  // following four functions takes care of data persistence
+  virtual PByte Load(FileOffset offset, size_t size);
+  virtual bool Read(FileOffset offset, size_t size, PByte dest);
+  virtual bool CanLoad();
+
+  // following functions takes care of data persistence.  prepareData()
+  // is called before anything is saved, releasePreparedData() after.
+  virtual void prepareData();
+  virtual void releasePreparedData();
   virtual int getIdSize();
-  virtual void saveId(std::ofstream& dest, int& offset);
-  virtual Entity* loadId(std::ifstream& source);
+  virtual void saveId(std::ofstream& dest, FileOffset& offset);
+  virtual Entity* loadId(std::istream& source, const int version);
   virtual void saveData(std::ofstream& dest);
 
 protected:
@@ -82,6 +93,8 @@ public:
   Entity* find(int index);
 
   void attach(Entity* entity);
+  // same as attach(), for entities known not to be here yet
+  void append(Entity* entity);
   void detach(Entity* entity, bool free = false);
   void detach(WideString& name, bool free = false);
   void detach(int index, bool free = false);
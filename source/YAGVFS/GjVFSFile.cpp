@@ -1,5 +1,7 @@
 
 #include "GjVFSFile.h"
+#include "GjVFSCodec.h"
+#include "GjVFSChecksum.h"
 #include "GjUnicodeUtils.h"
 #include <fstream>
 using namespace yaglib;
@@ -7,7 +9,9 @@ using namespace yaglib::vfs;
 
 
 File::File(const WideString& name, Entities* container) :
-  Entity(name, container), m_DataHolder(NULL)
+  Entity(name, container), m_DataHolder(NULL), m_Codec(cCodecNone),
+  m_PreparedSize(0), m_PreparedStoredSize(0), m_PreparedCodec(cCodecNone),
+  m_PreparedChecksum(0), m_PreparedOffset(-1)
 {
   m_DataHolder = new DataHolder(dynamic_cast<DemandLoader*>(this));
 }
@@ -33,42 +37,161 @@ void File::saveToFile(WideString& fileName)
     dest.write((char*)m_DataHolder->getData(), m_DataHolder->getDataSize());
 }
 
-int File::getIdSize()
+const int File::getCodec() const
 {
-  // we just add two ints which we will use to store the offset and size
-  // of the data associated with this file object
-  return Entity::getIdSize() + (sizeof(int) * 2); 
+  return m_Codec;
 }
 
-void File::saveId(std::ofstream& dest, int& offset)
+void File::setCodec(const int codec)
 {
-  Entity::saveId(dest, offset);
+  m_Codec = codec;
+}
+
+void File::prepareData()
+{
+  // compress now, the entry has to know the packed size before the
+  // data itself is written. if it doesn't shrink, it's stored as-is.
+  m_Packed.clear();
+  if((m_Codec != cCodecNone) && (m_DataHolder->getData() != NULL))
+    codec::compress(m_DataHolder->getData(), m_DataHolder->getDataSize(), m_Packed);
+
+  size_t dataSize = m_DataHolder->getDataSize();
+  if(m_Packed.empty())
+    setPrepared(dataSize, dataSize, cCodecNone,
+      checksum::crc32c(m_DataHolder->getData(), dataSize));
+  else
+    setPrepared(dataSize, m_Packed.size(), m_Codec,
+      checksum::crc32c(&m_Packed[0], m_Packed.size()));
+}
+
+void File::setPrepared(size_t dataSize, size_t storedSize, int codec,
+  unsigned int checksum, FileOffset sharedOffset)
+{
+  m_PreparedSize = dataSize;
+  m_PreparedStoredSize = storedSize;
+  m_PreparedCodec = codec;
+  m_PreparedChecksum = checksum;
+  m_PreparedOffset = sharedOffset;
+}
+
+const size_t File::getPreparedSize() const
+{
+  return m_PreparedSize;
+}
+
+const size_t File::getPreparedStoredSize() const
+{
+  return m_PreparedStoredSize;
+}
+
+const int File::getPreparedCodec() const
+{
+  return m_PreparedCodec;
+}
+
+const unsigned int File::getPreparedChecksum() const
+{
+  return m_PreparedChecksum;
+}
 
-  int bufSize = m_DataHolder->getDataSize();
-  int _offset = offset;
+const bool File::isPreparedShared() const
+{
+  return m_PreparedOffset >= 0;
+}
 
-  dest.write((char*)&bufSize, sizeof(int));
-  dest.write((char*)&_offset, sizeof(int));
+FileOffset File::placeData(FileOffset& offset) const
+{
+  // already there for some other entry
+  if(m_PreparedOffset >= 0)
+    return m_PreparedOffset;
+
+  // otherwise at the next aligned spot, see saveData()
+  offset = alignOffset(offset, cBlobAlignment);
+  FileOffset placed = offset;
+  offset += (FileOffset)m_PreparedStoredSize;
+  return placed;
+}
 
-  offset += bufSize;
+void File::releasePreparedData()
+{
+  std::vector<Byte>().swap(m_Packed);
 }
 
-Entity* File::loadId(std::ifstream& source)
+int File::getIdSize()
 {
-  Entity::loadId(source);
+  // the offset, stored size and unpacked size of the data of this
+  // file object, and the codec it is stored with
+  return Entity::getIdSize() + (sizeof(FileOffset) * 3) + sizeof(int); 
+}
 
-  int bufSize, offset;
+void File::saveId(std::ofstream& dest, FileOffset& offset)
+{
+  Entity::saveId(dest, offset);
+
+  FileOffset _offset = placeData(offset);
+  FileOffset bufSize = (FileOffset)m_PreparedStoredSize;
+  FileOffset dataSize = (FileOffset)m_PreparedSize;
+  int codec = m_PreparedCodec;
 
-  source.read((char*)&bufSize, sizeof(int));
-  source.read((char*)&offset, sizeof(int));
-  m_DataHolder->assign(offset, bufSize);
+  dest.write((char*)&_offset, sizeof(FileOffset));
+  dest.write((char*)&bufSize, sizeof(FileOffset));
+  dest.write((char*)&dataSize, sizeof(FileOffset));
+  dest.write((char*)&codec, sizeof(int));
+}
+
+Entity* File::loadId(std::istream& source, const int version)
+{
+  Entity::loadId(source, version);
+
+  FileOffset offset, bufSize, dataSize;
+  int codec = cCodecNone;
+  if(version >= cVersionLarge)
+  {
+    source.read((char*)&offset, sizeof(FileOffset));
+    source.read((char*)&bufSize, sizeof(FileOffset));
+    source.read((char*)&dataSize, sizeof(FileOffset));
+    source.read((char*)&codec, sizeof(int));
+  }
+  else
+  {
+    int _bufSize, _offset;
+    source.read((char*)&_bufSize, sizeof(int));
+    source.read((char*)&_offset, sizeof(int));
+    bufSize = _bufSize;
+    offset = _offset;
+
+    // the original format only had raw data
+    int _dataSize = _bufSize;
+    if(version >= cVersionCompressed)
+    {
+      source.read((char*)&codec, sizeof(int));
+      source.read((char*)&_dataSize, sizeof(int));
+    }
+    dataSize = _dataSize;
+  }
+
+  m_Codec = codec;
+  m_DataHolder->assign(offset, (size_t)bufSize, (size_t)dataSize, codec);
 
   return this;
 }
 
 void File::saveData(std::ofstream& dest)
 {
-  dest.write((char*)m_DataHolder->getData(), m_DataHolder->getDataSize());
+  alignData(dest);
+  if(!m_Packed.empty())
+    dest.write((char*)&m_Packed[0], (std::streamsize)m_Packed.size());
+  else
+    dest.write((char*)m_DataHolder->getData(), m_DataHolder->getDataSize());
+}
+
+void File::alignData(std::ostream& dest)
+{
+  static const char padding[cBlobAlignment] = { 0 };
+  FileOffset here = (FileOffset)dest.tellp();
+  FileOffset aligned = alignOffset(here, cBlobAlignment);
+  if(aligned > here)
+    dest.write(padding, (std::streamsize)(aligned - here));
 }
 
 DataHolder* const File::getDataHolder() const
@@ -25,14 +25,48 @@ public:
   void loadFromFile(WideString& fileName);
   void saveToFile(WideString& fileName);
 
-  // following four functions takes care of data persistence
+  // the codec this file is saved with. loaded files keep the codec
+  // they were stored with. data that does not compress is stored as-is.
+  const int getCodec() const;
+  void setCodec(const int codec);
+
+  // following functions takes care of data persistence
+  virtual void prepareData();
+  virtual void releasePreparedData();
   virtual int getIdSize();
-  virtual void saveId(std::ofstream& dest, int& offset);
-  virtual Entity* loadId(std::ifstream& source);
+  virtual void saveId(std::ofstream& dest, FileOffset& offset);
+  virtual Entity* loadId(std::istream& source, const int version);
   virtual void saveData(std::ofstream& dest);
 
+  // what saveId() records for the data. prepareData() sets this up,
+  // a builder writing the data on its own supplies it here instead.
+  // with sharedOffset set, the entry points at data already written
+  // there for another entry, and nothing is written for this one.
+  void setPrepared(size_t dataSize, size_t storedSize, int codec,
+    unsigned int checksum, FileOffset sharedOffset = -1);
+  const size_t getPreparedSize() const;
+  const size_t getPreparedStoredSize() const;
+  const int getPreparedCodec() const;
+  const unsigned int getPreparedChecksum() const;
+  const bool isPreparedShared() const;
+
+  // where the prepared data goes, given where the previous file's data
+  // ended. offset is moved past it.
+  FileOffset placeData(FileOffset& offset) const;
+
+  // pads the stream up to where the next blob goes
+  static void alignData(std::ostream& dest);
+
 private:
   DataHolder* m_DataHolder;
+  int m_Codec;
+  std::vector<Byte> m_Packed;   // compressed data, only while saving
+
+  size_t m_PreparedSize;
+  size_t m_PreparedStoredSize;
+  int m_PreparedCodec;
+  unsigned int m_PreparedChecksum; // of the stored form
+  FileOffset m_PreparedOffset;
 };
 
   } /* namespace vfs */
@@ -0,0 +1,234 @@
+
+#include "GjVFSFileStream.h"
+#include "GjVFSCodec.h"
+using namespace yaglib;
+using namespace yaglib::vfs;
+
+// block headers are little endian, whatever we run on
+static inline unsigned int read32(const Byte* p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+FileStream::FileStream(const File* file, const size_t bufferSize) :
+  m_Holder(NULL), m_Size(0), m_Position(0), m_Pinned(false), m_Packed(false),
+  m_Window(NULL), m_WindowStart(0), m_WindowSize(0), m_BufferSize(bufferSize),
+  m_Buffer(NULL)
+{
+  if(file == NULL)
+    return;
+
+  // streams read the stored data piecemeal, so they can't check it.
+  // what's known to be bad is refused, though.
+  if(file->getDataHolder()->hasFailedCheck())
+    return;
+
+  m_Holder = file->getDataHolder();
+  m_Size = m_Holder->getDataSize();
+
+  // whatever is in memory already is read in place. keep it
+  // pinned, so the cache doesn't pull it out from under us.
+  DataCache* cache = m_Holder->getCache();
+  if(cache != NULL)
+  {
+    cache->pin(m_Holder);
+    m_Pinned = true;
+  }
+  if(m_Holder->hasData())
+  {
+    m_Window = m_Pinned ? m_Holder->getPinnedData() : m_Holder->getData();
+    m_WindowSize = m_Size;
+
+    // data referenced straight from a mapping is checked the first time
+    // it's handed out, and that's where a bad one turns up
+    if((m_Window == NULL) && (m_Size > 0))
+    {
+      if(m_Pinned)
+        cache->unpin(m_Holder);
+      m_Pinned = false;
+      m_Holder = NULL;
+      m_Size = 0;
+      m_WindowSize = 0;
+    }
+    return;
+  }
+
+  m_Packed = (m_Holder->getCodec() != cCodecNone);
+  if(m_Packed)
+    m_BufferSize = cCodecBlockSize;
+  else if(m_BufferSize > m_Size)
+    m_BufferSize = m_Size;
+  if(m_BufferSize == 0)
+    m_BufferSize = 1;
+  m_Buffer = new Byte [m_BufferSize];
+}
+
+FileStream::~FileStream()
+{
+  if(m_Pinned)
+    m_Holder->getCache()->unpin(m_Holder);
+  delete [] m_Buffer;
+}
+
+const bool FileStream::isOpen() const
+{
+  return m_Holder != NULL;
+}
+
+size_t FileStream::read(void* dest, size_t size)
+{
+  if(m_Holder == NULL)
+    return 0;
+
+  PByte out = (PByte) dest;
+  size_t done = 0;
+  if(size > m_Size - m_Position)
+    size = m_Size - m_Position;
+
+  while(done < size)
+  {
+    size_t wanted = size - done;
+
+    // big unpacked reads skip the buffer altogether
+    if(!m_Packed && (m_Buffer != NULL) && (wanted >= m_BufferSize))
+    {
+      if(!m_Holder->readStored(m_Position, wanted, out + done))
+        break;
+      m_Position += wanted;
+      done += wanted;
+      break;
+    }
+
+    if((m_Position < m_WindowStart) || (m_Position >= m_WindowStart + m_WindowSize))
+      if(!fill(m_Position))
+        break;
+
+    size_t available = m_WindowStart + m_WindowSize - m_Position;
+    size_t count = (wanted < available) ? wanted : available;
+    memcpy(out + done, m_Window + (m_Position - m_WindowStart), count);
+    m_Position += count;
+    done += count;
+  }
+
+  return done;
+}
+
+bool FileStream::seek(long offset, std::ios_base::seekdir dir)
+{
+  long long target;
+  if(dir == std::ios_base::beg)
+    target = offset;
+  else if(dir == std::ios_base::cur)
+    target = (long long)m_Position + offset;
+  else
+    target = (long long)m_Size + offset;
+
+  // nothing is read here, the next read() fetches what it needs
+  if((target < 0) || (target > (long long)m_Size))
+    return false;
+
+  m_Position = (size_t)target;
+  return true;
+}
+
+const size_t FileStream::tell() const
+{
+  return m_Position;
+}
+
+const size_t FileStream::getSize() const
+{
+  return m_Size;
+}
+
+const bool FileStream::eof() const
+{
+  return m_Position >= m_Size;
+}
+
+bool FileStream::fill(const size_t position)
+{
+  if(m_Buffer == NULL)
+    return false;
+
+  return m_Packed ? fillPacked(position) : fillRaw(position);
+}
+
+bool FileStream::fillRaw(const size_t position)
+{
+  size_t size = m_Size - position;
+  if(size > m_BufferSize)
+    size = m_BufferSize;
+
+  m_WindowSize = 0;
+  if(!m_Holder->readStored(position, size, m_Buffer))
+    return false;
+
+  m_Window = m_Buffer;
+  m_WindowStart = position;
+  m_WindowSize = size;
+  return true;
+}
+
+bool FileStream::fillPacked(const size_t position)
+{
+  // every block but the last unpacks to exactly cCodecBlockSize bytes
+  size_t block = position / cCodecBlockSize;
+  size_t blockStart = block * cCodecBlockSize;
+  size_t blockSize = m_Size - blockStart;
+  if(blockSize > cCodecBlockSize)
+    blockSize = cCodecBlockSize;
+
+  m_WindowSize = 0;
+  size_t offset;
+  if(!findBlock(block, offset))
+    return false;
+
+  Byte header[sizeof(unsigned int)];
+  if(!m_Holder->readStored(offset, sizeof(header), header))
+    return false;
+
+  unsigned int blockHeader = read32(header);
+  size_t packed = blockHeader & ~cCodecStoredBlock;
+  offset += sizeof(header);
+
+  if(blockHeader & cCodecStoredBlock)
+  {
+    if((packed != blockSize) || !m_Holder->readStored(offset, packed, m_Buffer))
+      return false;
+  }
+  else
+  {
+    m_Block.resize(packed);
+    if((packed == 0) || !m_Holder->readStored(offset, packed, &m_Block[0]) ||
+       !codec::decompressBlock(&m_Block[0], packed, m_Buffer, blockSize))
+      return false;
+  }
+
+  m_Window = m_Buffer;
+  m_WindowStart = blockStart;
+  m_WindowSize = blockSize;
+  return true;
+}
+
+bool FileStream::findBlock(const size_t block, size_t& offset)
+{
+  // the blocks are only found by walking their headers, so remember
+  // every one seen. going back, or forward again, is then free.
+  if(m_BlockOffsets.empty())
+    m_BlockOffsets.push_back(0);
+
+  while(m_BlockOffsets.size() <= block)
+  {
+    Byte header[sizeof(unsigned int)];
+    size_t last = m_BlockOffsets.back();
+    if(!m_Holder->readStored(last, sizeof(header), header))
+      return false;
+
+    unsigned int blockHeader = read32(header);
+    m_BlockOffsets.push_back(last + sizeof(header) + (blockHeader & ~cCodecStoredBlock));
+  }
+
+  offset = m_BlockOffsets[block];
+  return true;
+}
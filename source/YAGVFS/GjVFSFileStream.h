@@ -0,0 +1,72 @@
+
+#ifndef GJ_VFS_FILE_STREAM_HEADER
+#define GJ_VFS_FILE_STREAM_HEADER
+
+#include "GjDefs.h"
+#include "GjVFSDefs.h"
+#include "GjVFSFile.h"
+#include "GjVFSDataHolder.h"
+
+#include <ios>
+#include <boost/utility.hpp>
+
+namespace yaglib
+{
+  namespace vfs
+  {
+
+const size_t cDefStreamBufferSize = 65536;
+
+/**
+ * reads a file a piece at a time instead of loading all of it.  data
+ * that is already in memory is read in place; otherwise the stored form
+ * is read from the archive bufferSize bytes at a time, and packed files
+ * are unpacked one codec block at a time (so their buffer is always
+ * cCodecBlockSize).  either way, memory use doesn't grow with the file.
+ *
+ * the file must outlive the stream.  one stream must not be shared by
+ * threads, but any number of streams may read the same file at once.
+ */
+class FileStream : private boost::noncopyable
+{
+public:
+  FileStream(const File* file, const size_t bufferSize = cDefStreamBufferSize);
+  virtual ~FileStream();
+
+  // false if there was no file, or its data is known to be bad
+  const bool isOpen() const;
+
+  // returns how much was actually read, short only at the end or on errors
+  size_t read(void* dest, size_t size);
+  bool seek(long offset, std::ios_base::seekdir dir = std::ios_base::beg);
+  const size_t tell() const;
+  const size_t getSize() const;
+  const bool eof() const;
+
+private:
+  DataHolder* m_Holder;
+  size_t m_Size;
+  size_t m_Position;
+  bool m_Pinned;
+  bool m_Packed;
+
+  // the piece of the file we currently have at hand
+  PByte m_Window;
+  size_t m_WindowStart;
+  size_t m_WindowSize;
+
+  size_t m_BufferSize;
+  PByte m_Buffer;
+  std::vector<Byte> m_Block;          // a packed block, as stored
+  std::vector<size_t> m_BlockOffsets; // where the blocks found so far start
+
+  bool fill(const size_t position);
+  bool fillRaw(const size_t position);
+  bool fillPacked(const size_t position);
+  bool findBlock(const size_t block, size_t& offset);
+};
+
+  } /* namespace vfs */
+} /* namespace yaglib */
+
+#endif /* GJ_VFS_FILE_STREAM_HEADER */
@@ -0,0 +1,441 @@
+
+#include "GjVFSFlatToc.h"
+#include "GjVFSVolume.h"
+#include "GjUnicodeUtils.h"
+#include <algorithm>
+#include <map>
+using namespace yaglib;
+using namespace yaglib::vfs;
+
+static inline bool isSeparator(const WideChar c)
+{
+  return (c == '/') || (c == '\\');
+}
+
+FlatToc::FlatToc(Volume* volume, const PByte mappedData, const size_t mappedSize) :
+  m_Volume(volume), m_MappedData(mappedData), m_MappedSize(mappedSize),
+  m_Entries(NULL), m_EntryCount(0), m_EntrySize(0), m_Names(NULL), m_NamesSize(0),
+  m_Checksums(false), m_PathsIndexed(false)
+{
+}
+
+FlatToc::~FlatToc()
+{
+}
+
+bool FlatToc::load(std::istream& source, const size_t size)
+{
+  m_Buffer.resize(size);
+  if(size > 0)
+    source.read((char*)&m_Buffer[0], (std::streamsize)size);
+  return (size > 0) && !source.fail() && open(&m_Buffer[0], size);
+}
+
+bool FlatToc::open(const PByte table, const size_t size)
+{
+  if(size < sizeof(VFS_TOC_HEADER))
+    return false;
+
+  const VFS_TOC_HEADER* header = (const VFS_TOC_HEADER*) table;
+  if((header->entryCount <= 0) || (header->entrySize < cTocBaseEntrySize) ||
+     (header->namePoolSize <= 0))
+    return false;
+
+  size_t available = size - sizeof(VFS_TOC_HEADER);
+  if((size_t)header->entryCount > available / header->entrySize)
+    return false;
+  size_t entriesSize = (size_t)header->entryCount * header->entrySize;
+  if((size_t)header->namePoolSize > available - entriesSize)
+    return false;
+
+  m_Entries = table + sizeof(VFS_TOC_HEADER);
+  m_EntryCount = header->entryCount;
+  m_EntrySize = header->entrySize;
+  m_Names = (const char*) (m_Entries + entriesSize);
+  m_NamesSize = header->namePoolSize;
+  m_Checksums = (header->flags & cTocChecksums) && (m_EntrySize >= (int)sizeof(VFS_TOC_ENTRY));
+  if(!validate())
+  {
+    m_EntryCount = 0;
+    return false;
+  }
+
+  // the root is the volume itself, everything else comes on demand
+  m_Entities.assign(m_EntryCount, (Entity*)NULL);
+  m_Entities[0] = m_Volume;
+  return true;
+}
+
+const VFS_TOC_ENTRY& FlatToc::entry(const int index) const
+{
+  return *(const VFS_TOC_ENTRY*) (m_Entries + (size_t)index * m_EntrySize);
+}
+
+bool FlatToc::validate() const
+{
+  // everything is checked once, up front, so nothing has to be later
+  for(int i = 0; i < m_EntryCount; i++)
+  {
+    const VFS_TOC_ENTRY& e = entry(i);
+    if((e.nameOffset < 0) || (e.nameLength < 0) || (e.nameOffset >= m_NamesSize) ||
+       (e.nameLength >= m_NamesSize - e.nameOffset) || (m_Names[e.nameOffset + e.nameLength] != 0))
+      return false;
+
+    // parents always come before their children
+    if((i == 0) ? ((e.parent != -1) || !(e.flags & cTocFolder)) : ((e.parent < 0) || (e.parent >= i)))
+      return false;
+
+    if(e.flags & cTocFolder)
+    {
+      if((e.childCount < 0) || ((e.childCount > 0) &&
+         ((e.firstChild <= i) || (e.firstChild > m_EntryCount - e.childCount))))
+        return false;
+      for(int child = e.firstChild; child < e.firstChild + e.childCount; child++)
+        if(entry(child).parent != i)
+          return false;
+      continue;
+    }
+
+    if((e.offset < 0) || (e.storedSize < 0) || (e.dataSize < 0) ||
+       ((unsigned long long)e.storedSize > (size_t)-1) ||
+       ((unsigned long long)e.dataSize > (size_t)-1))
+      return false;
+    if((m_MappedData != NULL) && ((e.offset > (FileOffset)m_MappedSize) ||
+       (e.storedSize > (FileOffset)m_MappedSize - e.offset)))
+      return false;
+    // a share is a single hop to an entry with data of its own, and it
+    // has to be the same data, the sizes are taken from this entry
+    if(e.shares >= 0)
+    {
+      if((e.shares >= m_EntryCount) || (e.shares == i))
+        return false;
+      const VFS_TOC_ENTRY& primary = entry(e.shares);
+      if((primary.flags & cTocFolder) || (primary.shares >= 0) || (primary.offset != e.offset) ||
+         (primary.storedSize != e.storedSize) || (primary.dataSize != e.dataSize) ||
+         (primary.codec != e.codec))
+        return false;
+    }
+  }
+
+  return true;
+}
+
+const int FlatToc::getEntryCount() const
+{
+  return m_EntryCount;
+}
+
+const bool FlatToc::hasChecksums() const
+{
+  return m_Checksums;
+}
+
+const int FlatToc::find(const WideChar* path, size_t length) const
+{
+  if(m_EntryCount == 0)
+    return -1;
+  if(!m_PathsIndexed)
+    indexPaths();
+
+  // trim the separators off both ends, the keys never have them
+  while((length > 0) && isSeparator(*path))
+  {
+    path++;
+    length--;
+  }
+  while((length > 0) && isSeparator(path[length-1]))
+    length--;
+
+  return m_Paths.find(path, length);
+}
+
+void FlatToc::indexPaths() const
+{
+  ScopedLock lock(m_Lock);
+  if(m_PathsIndexed)
+    return;
+
+  // parents come before their children, so each path is its parent's
+  // plus a name. only the keys are kept, the paths go when we're done.
+  std::vector<WideString> paths(m_EntryCount);
+  m_Paths.reserve(m_EntryCount);
+  m_Paths.insert(paths[0], 0);
+  for(int i = 1; i < m_EntryCount; i++)
+  {
+    const VFS_TOC_ENTRY& e = entry(i);
+    WideString name = UTF8String(m_Names + e.nameOffset).asWideString();
+    paths[i] = (e.parent == 0) ? name : paths[e.parent] + PATH_SEPARATOR + name;
+    m_Paths.insert(paths[i], i);
+  }
+
+  // readers seeing this set use the index unlocked
+  MemoryBarrier();
+  m_PathsIndexed = true;
+}
+
+Entity* FlatToc::materialize(const int index)
+{
+  if((index < 0) || (index >= m_EntryCount))
+    return NULL;
+  if(index == 0)
+    return m_Entities[0];
+
+  // an entity is created along with the rest of its folder. it's only
+  // looked at once the folder is complete, someone else may be working
+  // on it right now.
+  Folder* folder = dynamic_cast<Folder*>(materialize(entry(index).parent));
+  if(folder == NULL)
+    return NULL;
+
+  folder->populate();
+  return m_Entities[index];
+}
+
+void FlatToc::populate(Folder* folder, const int index)
+{
+  // the lock is reentrant, which linking shared data below relies on.
+  // the folder's entry is cleared while we're at it, so if that comes
+  // back here for this same folder, it's left alone.
+  ScopedLock lock(m_Lock);
+  if((folder->m_Toc == NULL) || (index < 0) || (folder->m_TocEntry < 0))
+    return;
+  folder->m_TocEntry = -1;
+
+  const VFS_TOC_ENTRY& e = entry(index);
+  DataCache* cache = m_Volume->getCache();
+  bool sharing = false;
+
+  for(int i = e.firstChild; i < e.firstChild + e.childCount; i++)
+  {
+    const VFS_TOC_ENTRY& child = entry(i);
+    WideString name = UTF8String(m_Names + child.nameOffset).asWideString();
+
+    if(child.flags & cTocFolder)
+    {
+      Folder* subFolder = new Folder(name, NULL);
+      subFolder->setPending(this, i);
+      folder->m_Folders->append(subFolder);
+      m_Entities[i] = subFolder;
+      continue;
+    }
+
+    File* file = new File(name, NULL);
+    file->setCodec(child.codec);
+    DataHolder* holder = file->getDataHolder();
+    holder->assign(child.offset, (size_t)child.storedSize, (size_t)child.dataSize, child.codec);
+    if(m_MappedData != NULL)
+      holder->referenceStored(m_MappedData + (size_t)child.offset);
+    holder->setCache(cache);
+    if(m_Checksums)
+      holder->setChecksum(child.checksum, m_Volume->getVerify());
+
+    folder->m_Files->append(file);
+    m_Entities[i] = file;
+    sharing = sharing || (child.shares >= 0);
+  }
+
+  // the entries shared with may live in other folders, even this one,
+  // so they're only looked up once all of this one's entities exist
+  for(int i = e.firstChild; sharing && (i < e.firstChild + e.childCount); i++)
+  {
+    const VFS_TOC_ENTRY& child = entry(i);
+    if((child.flags & cTocFolder) || (child.shares < 0))
+      continue;
+
+    File* primary = dynamic_cast<File*>(materialize(child.shares));
+    if(primary != NULL)
+      static_cast<File*>(m_Entities[i])->getDataHolder()->shareWith(primary->getDataHolder());
+  }
+
+  // and that's it. readers seeing this cleared can use it all unlocked.
+  MemoryBarrier();
+  folder->m_Toc = NULL;
+}
+
+void FlatToc::populateAll()
+{
+  if(m_EntryCount > 0)
+    populateAll(m_Volume);
+}
+
+void FlatToc::populateInto(Folder* root)
+{
+  if(m_EntryCount == 0)
+    return;
+
+  // entries sharing data find each other through here
+  m_Entities[0] = root;
+  root->setPending(this, 0);
+  populateAll(root);
+}
+
+void FlatToc::populateAll(Folder* folder)
+{
+  Folders* folders = folder->getFolders();
+  for(Entities::iterator iter = folders->begin(); iter != folders->end(); iter++)
+    populateAll(dynamic_cast<Folder*>(*iter));
+  folder->getFiles();
+}
+
+void FlatToc::attachCache(DataCache* cache)
+{
+  ScopedLock lock(m_Lock);
+  for(std::vector<Entity*>::iterator iter = m_Entities.begin(); iter != m_Entities.end(); iter++)
+    if((*iter != NULL) && !(*iter)->isFolder())
+      dynamic_cast<File*>(*iter)->getDataHolder()->setCache(cache);
+}
+
+void FlatToc::setVerify(const bool verify)
+{
+  ScopedLock lock(m_Lock);
+  for(std::vector<Entity*>::iterator iter = m_Entities.begin(); iter != m_Entities.end(); iter++)
+    if((*iter != NULL) && !(*iter)->isFolder())
+      dynamic_cast<File*>(*iter)->getDataHolder()->setVerify(verify);
+}
+
+//
+// writing
+///////////
+
+struct TocName
+{
+  Entity* entity;
+  std::string name;
+};
+
+static bool nameBefore(const TocName& a, const TocName& b)
+{
+  size_t length = (a.name.size() < b.name.size()) ? a.name.size() : b.name.size();
+  int order = memcmp(a.name.data(), b.name.data(), length);
+  return (order != 0) ? (order < 0) : (a.name.size() < b.name.size());
+}
+
+static void measureFolder(Folder* folder, size_t& count, size_t& names)
+{
+  Folders* folders = folder->getFolders();
+  for(Entities::iterator iter = folders->begin(); iter != folders->end(); iter++)
+  {
+    count++;
+    names += UTF8String((*iter)->getName()).c_len() + 1;
+    measureFolder(dynamic_cast<Folder*>(*iter), count, names);
+  }
+
+  Files* files = folder->getFiles();
+  for(Entities::iterator iter = files->begin(); iter != files->end(); iter++)
+  {
+    count++;
+    names += UTF8String((*iter)->getName()).c_len() + 1;
+  }
+}
+
+size_t FlatToc::measure(Folder* root)
+{
+  size_t count = 1;
+  size_t names = UTF8String(root->getName()).c_len() + 1;
+  measureFolder(root, count, names);
+  return sizeof(VFS_TOC_HEADER) + (count * sizeof(VFS_TOC_ENTRY)) + names;
+}
+
+static void addEntry(std::vector<VFS_TOC_ENTRY>& entries, std::string& names,
+  const std::string& name, const int parent, const bool isFolder)
+{
+  VFS_TOC_ENTRY e;
+  memset(&e, 0, sizeof(VFS_TOC_ENTRY));
+  e.nameOffset = (int)names.size();
+  e.nameLength = (int)name.size();
+  e.parent = parent;
+  e.flags = isFolder ? cTocFolder : 0;
+  e.shares = -1;
+  entries.push_back(e);
+
+  names.append(name);
+  names.push_back('\0');
+}
+
+// the data goes out in the same order saveData() walks the tree
+static void placeFolder(Folder* folder, std::vector<VFS_TOC_ENTRY>& entries,
+  std::map<const Entity*, int>& indices, std::map<FileOffset, int>& written, FileOffset& offset)
+{
+  Folders* folders = folder->getFolders();
+  for(Entities::iterator iter = folders->begin(); iter != folders->end(); iter++)
+    placeFolder(dynamic_cast<Folder*>(*iter), entries, indices, written, offset);
+
+  Files* files = folder->getFiles();
+  for(Entities::iterator iter = files->begin(); iter != files->end(); iter++)
+  {
+    File* file = dynamic_cast<File*>(*iter);
+    int index = indices[file];
+    VFS_TOC_ENTRY& e = entries[index];
+    e.offset = file->placeData(offset);
+    e.storedSize = (FileOffset)file->getPreparedStoredSize();
+    e.dataSize = (FileOffset)file->getPreparedSize();
+    e.codec = file->getPreparedCodec();
+    e.checksum = file->getPreparedChecksum();
+
+    if(file->isPreparedShared())
+    {
+      std::map<FileOffset, int>::iterator first = written.find(e.offset);
+      if(first != written.end())
+        e.shares = first->second;
+    }
+    else if(e.storedSize > 0)
+      written[e.offset] = index;
+  }
+}
+
+bool FlatToc::write(std::ostream& dest, Folder* root, FileOffset dataOffset)
+{
+  std::vector<VFS_TOC_ENTRY> entries;
+  std::vector<Entity*> entities;
+  std::map<const Entity*, int> indices;
+  std::string names;
+
+  // breadth first, so each folder's children end up next to each other
+  addEntry(entries, names, UTF8String(root->getName()).c_str(), -1, true);
+  entities.push_back(root);
+  for(size_t i = 0; i < entities.size(); i++)
+  {
+    if(!entities[i]->isFolder())
+      continue;
+
+    Folder* folder = dynamic_cast<Folder*>(entities[i]);
+    std::vector<TocName> children;
+    Folders* folders = folder->getFolders();
+    Files* files = folder->getFiles();
+    for(Entities::iterator iter = folders->begin(); iter != folders->end(); iter++)
+    {
+      TocName child = { *iter, UTF8String((*iter)->getName()).c_str() };
+      children.push_back(child);
+    }
+    for(Entities::iterator iter = files->begin(); iter != files->end(); iter++)
+    {
+      TocName child = { *iter, UTF8String((*iter)->getName()).c_str() };
+      children.push_back(child);
+    }
+    std::sort(children.begin(), children.end(), nameBefore);
+
+    entries[i].firstChild = (int)entries.size();
+    entries[i].childCount = (int)children.size();
+    for(std::vector<TocName>::iterator iter = children.begin(); iter != children.end(); iter++)
+    {
+      indices[iter->entity] = (int)entries.size();
+      addEntry(entries, names, iter->name, (int)i, iter->entity->isFolder());
+      entities.push_back(iter->entity);
+    }
+  }
+
+  std::map<FileOffset, int> written;
+  placeFolder(root, entries, indices, written, dataOffset);
+
+  VFS_TOC_HEADER header;
+  memset(&header, 0, sizeof(VFS_TOC_HEADER));
+  header.entryCount = (int)entries.size();
+  header.entrySize = sizeof(VFS_TOC_ENTRY);
+  header.namePoolSize = (int)names.size();
+  header.flags = cTocChecksums;
+
+  dest.write((char*)&header, sizeof(VFS_TOC_HEADER));
+  dest.write((char*)&entries[0], (std::streamsize)(entries.size() * sizeof(VFS_TOC_ENTRY)));
+  dest.write(names.data(), (std::streamsize)names.size());
+  return dest.good();
+}
@@ -0,0 +1,104 @@
+
+#ifndef GJ_VFS_FLAT_TOC_HEADER
+#define GJ_VFS_FLAT_TOC_HEADER
+
+#include "GjDefs.h"
+#include "GjVFSDefs.h"
+#include "GjVFSEntities.h"
+#include "GjVFSFile.h"
+#include "GjVFSFolder.h"
+#include "GjVFSDataCache.h"
+#include "GjThreads.h"
+#include "GjStringIndex.h"
+
+#include <ostream>
+#include <vector>
+#include <boost/utility.hpp>
+
+namespace yaglib
+{
+  namespace vfs
+  {
+
+class Volume;
+
+/**
+ * a volume's structures as a single table (see VFS_TOC_HEADER).  the
+ * table is either read in one go or used in place in a mapped archive.
+ * paths are looked up in the table itself; entities are only created
+ * when something is looked up or a folder's contents are enumerated,
+ * and then a folder's worth at a time.
+ *
+ * lookups may come from any number of threads.  the table itself is
+ * never written to, and creating a folder's contents is serialized, but
+ * only that: a folder, once filled in, is read without locking.  the
+ * first lookup hashes every entry's path, the same as a PathIndex does
+ * for a tree, and from then on a lookup is a single probe.
+ */
+class FlatToc : private boost::noncopyable
+{
+public:
+  // mappedData is the whole archive when it is mapped, file data is
+  // then referenced in place. otherwise it's loaded through the volume.
+  FlatToc(Volume* volume, const PByte mappedData = NULL, const size_t mappedSize = 0);
+  ~FlatToc();
+
+  // table is size bytes starting at the table header, which must stay
+  // valid for as long as we do. load() keeps its own copy instead.
+  bool open(const PByte table, const size_t size);
+  bool load(std::istream& source, const size_t size);
+
+  const int getEntryCount() const;
+  const bool hasChecksums() const;
+
+  // the entry a path leads to, or -1. only the first call allocates.
+  const int find(const WideChar* path, size_t length) const;
+
+  // the entity of an entry, creating its folder's contents if needed
+  Entity* materialize(const int index);
+  // fills in a pending folder, if no one else has
+  void populate(Folder* folder, const int index);
+  void populateAll();
+  // builds the whole tree under root instead of the volume, to have it
+  // ready before it's put in place. the table isn't used after that.
+  void populateInto(Folder* root);
+
+  // entities already created; those created later pick it up themselves
+  void attachCache(DataCache* cache);
+  void setVerify(const bool verify);
+
+  // the size of the table written for a tree, and the writing itself.
+  // the files must have been prepared.
+  static size_t measure(Folder* root);
+  static bool write(std::ostream& dest, Folder* root, FileOffset dataOffset);
+
+private:
+  Volume* m_Volume;
+  PByte m_MappedData;
+  size_t m_MappedSize;
+
+  std::vector<Byte> m_Buffer;
+  PByte m_Entries;
+  int m_EntryCount;
+  int m_EntrySize;
+  const char* m_Names;
+  int m_NamesSize;
+  bool m_Checksums;
+
+  std::vector<Entity*> m_Entities;   // guarded by m_Lock while populating
+  mutable CriticalSection m_Lock;
+
+  // every entry by path, built by the first lookup
+  mutable StringIndex<PathChars> m_Paths;
+  mutable volatile bool m_PathsIndexed;
+
+  const VFS_TOC_ENTRY& entry(const int index) const;
+  bool validate() const;
+  void indexPaths() const;
+  void populateAll(Folder* folder);
+};
+
+  } /* namespace vfs */
+} /* namespace yaglib */
+
+#endif /* GJ_VFS_FLAT_TOC_HEADER */
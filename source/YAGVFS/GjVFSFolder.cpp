@@ -1,10 +1,12 @@
 
 #include "GjVFSFolder.h"
+#include "GjVFSFlatToc.h"
 using namespace yaglib;
 using namespace yaglib::vfs;
 
 Folder::Folder(const WideString& name, Entities* container) :
-  Entity(name, container), m_Folders(NULL), m_Files(NULL)
+  Entity(name, container), m_Folders(NULL), m_Files(NULL), m_Toc(NULL),
+  m_TocEntry(-1)
 {
   m_Folders = new Folders(this);
   m_Files = new Files(this);
@@ -18,14 +20,17 @@ Folder::~Folder()
 
 void Folder::clear()
 {
+  // whatever wasn't created yet is simply forgotten
+  m_Toc = NULL;
   m_Folders->clear();
   m_Files->clear();
 }
 
 void Folder::propagateIdentityChange()
 {
+  // all the way down, names are never worked out on the fly
   for(Entities::iterator iter = m_Folders->begin(); iter != m_Folders->end(); iter++)
-    (*iter)->assembleQualifiedName();
+    static_cast<Folder*>(*iter)->containerChanged();
 
   for(Entities::iterator iter = m_Files->begin(); iter != m_Files->end(); iter++)
     (*iter)->assembleQualifiedName();
@@ -33,6 +38,7 @@ void Folder::propagateIdentityChange()
 
 void Folder::containerChanged()
 {
+  Entity::containerChanged();
   propagateIdentityChange();
 }
 
@@ -44,12 +50,14 @@ void Folder::nameChanged()
 
 bool Folder::nameAvailable(const WideString& nameToCheck)
 {
+  populate();
   return (m_Folders->find(nameToCheck) == NULL) &&
          (m_Files->find(nameToCheck) == NULL);
 }
 
 void Folder::attach(Entity* entity)
 {
+  populate();
   if(entity != NULL) 
   {
     if(entity->isFolder())
@@ -61,6 +69,7 @@ void Folder::attach(Entity* entity)
 
 void Folder::detach(Entity* entity, bool free)
 {
+  populate();
   if(entity != NULL) 
   {
     if(entity->isFolder())
@@ -72,6 +81,7 @@ void Folder::detach(Entity* entity, bool free)
 
 Folder* Folder::createFolder(const WideString& name)
 {
+  populate();
   if(!nameAvailable(name)) return NULL;
 
   Folder* folder = new Folder(name, NULL);
@@ -81,6 +91,7 @@ Folder* Folder::createFolder(const WideString& name)
 
 File* Folder::createFile(const WideString& name)
 {
+  populate();
   if(!nameAvailable(name)) return NULL;
 
   File* file = new File(name, NULL);
@@ -88,6 +99,28 @@ File* Folder::createFile(const WideString& name)
   return file;
 }
 
+void Folder::prepareData()
+{
+  Folders* folders = getFolders();
+  for(Entities::iterator iter = folders->begin(); iter != folders->end(); iter++)
+    (*iter)->prepareData();
+
+  Files* files = getFiles();
+  for(Entities::iterator iter = files->begin(); iter != files->end(); iter++)
+    (*iter)->prepareData();
+}
+
+void Folder::releasePreparedData()
+{
+  Folders* folders = getFolders();
+  for(Entities::iterator iter = folders->begin(); iter != folders->end(); iter++)
+    (*iter)->releasePreparedData();
+
+  Files* files = getFiles();
+  for(Entities::iterator iter = files->begin(); iter != files->end(); iter++)
+    (*iter)->releasePreparedData();
+}
+
 int Folder::getIdSize()
 {
   // the 2 ints are for the file and folder count we will store
@@ -104,7 +137,7 @@ int Folder::getIdSize()
   return result;
 }
 
-void Folder::saveId(std::ofstream& dest, int& offset)
+void Folder::saveId(std::ofstream& dest, FileOffset& offset)
 {
   Entity::saveId(dest, offset);
 
@@ -122,9 +155,9 @@ void Folder::saveId(std::ofstream& dest, int& offset)
     (*iter)->saveId(dest, offset);
 }
 
-Entity* Folder::loadId(std::ifstream& source)
+Entity* Folder::loadId(std::istream& source, const int version)
 {
-  Entity::loadId(source);
+  Entity::loadId(source, version);
   int count;
 
   source.read((char*)&count, sizeof(int));
@@ -132,7 +165,7 @@ Entity* Folder::loadId(std::ifstream& source)
     for(int i = 0; i < count; i++)
     {
       Folder* folder = createFolder(L"");
-      folder->loadId(source);
+      folder->loadId(source, version);
     }
 
   source.read((char*)&count, sizeof(int));
@@ -140,7 +173,7 @@ Entity* Folder::loadId(std::ifstream& source)
     for(int i = 0; i < count; i++)
     {
       File* file = createFile(L"");
-      file->loadId(source);
+      file->loadId(source, version);
     }
 
   return this;
@@ -164,14 +197,35 @@ const bool Folder::isFolder() const
 
 Folders* const Folder::getFolders() const
 {
+  populate();
   return m_Folders;
 }
 
 Files* const Folder::getFiles() const
 {
+  populate();
   return m_Files;
 }
 
+void Folder::setPending(FlatToc* toc, const int entry)
+{
+  m_Toc = toc;
+  m_TocEntry = entry;
+}
+
+const bool Folder::isPending() const
+{
+  return m_Toc != NULL;
+}
+
+void Folder::populate() const
+{
+  // once it's NULL, the contents are there and never change again
+  FlatToc* toc = m_Toc;
+  if(toc != NULL)
+    toc->populate(const_cast<Folder*>(this), m_TocEntry);
+}
+
 Files::Files(Entity* owner) : Entities(owner)
 {
 }
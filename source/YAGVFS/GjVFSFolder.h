@@ -21,6 +21,7 @@ public:
 };
 
 class Folder; // forward declaration
+class FlatToc;
 
 class Folders : public Entities
 {
@@ -48,10 +49,18 @@ public:
   Folder* createFolder(const WideString& name);
   File* createFile(const WideString& name);
 
-  // following four functions takes care of data persistence
+  // for flat tables of contents: the folder's contents are created from
+  // the given entry the first time anything asks for them. that may be
+  // several threads at once, the table sees to it that it's done once.
+  void setPending(FlatToc* toc, const int entry);
+  const bool isPending() const;
+
+  // following functions takes care of data persistence
+  virtual void prepareData();
+  virtual void releasePreparedData();
   virtual int getIdSize();
-  virtual void saveId(std::ofstream& dest, int& offset);
-  virtual Entity* loadId(std::ifstream& source);
+  virtual void saveId(std::ofstream& dest, FileOffset& offset);
+  virtual Entity* loadId(std::istream& source, const int version);
   virtual void saveData(std::ofstream& dest);
 
 protected:
@@ -60,10 +69,15 @@ protected:
   virtual bool nameAvailable(const WideString& nameToCheck);
 
 private:
+  friend class FlatToc;
+
   Folders* m_Folders;
   Files* m_Files;
+  mutable FlatToc* volatile m_Toc;  // cleared once the contents are complete
+  int m_TocEntry;
 
   void propagateIdentityChange();
+  void populate() const;
 };
 
   } /* namespace vfs */
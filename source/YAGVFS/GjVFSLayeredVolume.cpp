@@ -0,0 +1,185 @@
+
+#include "GjVFSLayeredVolume.h"
+using namespace yaglib;
+using namespace yaglib::vfs;
+
+LayeredVolume::LayeredVolume() : m_Cache(NULL), m_Verify(false)
+{
+}
+
+LayeredVolume::~LayeredVolume()
+{
+  unmountAll();
+}
+
+bool LayeredVolume::mount(const WideString& fileName)
+{
+  ReadOnlyVolume* layer = new ReadOnlyVolume();
+  if(!layer->mount(fileName))
+  {
+    delete layer;
+    return false;
+  }
+
+  layer->setCache(m_Cache);
+  layer->setVerify(m_Verify);
+  m_Layers.push_back(layer);
+  resolve();
+  return true;
+}
+
+void LayeredVolume::unmountAll()
+{
+  m_Index.clear();
+  for(std::vector<ReadOnlyVolume*>::iterator iter = m_Layers.begin(); iter != m_Layers.end(); iter++)
+    delete *iter;
+  m_Layers.clear();
+}
+
+const int LayeredVolume::getLayerCount() const
+{
+  return (int)m_Layers.size();
+}
+
+ReadOnlyVolume* LayeredVolume::getLayer(const int index) const
+{
+  return ((index >= 0) && (index < (int)m_Layers.size())) ? m_Layers[index] : NULL;
+}
+
+void LayeredVolume::setCache(DataCache* cache)
+{
+  m_Cache = cache;
+  for(std::vector<ReadOnlyVolume*>::iterator iter = m_Layers.begin(); iter != m_Layers.end(); iter++)
+    (*iter)->setCache(cache);
+}
+
+void LayeredVolume::setVerify(const bool verify)
+{
+  m_Verify = verify;
+  for(std::vector<ReadOnlyVolume*>::iterator iter = m_Layers.begin(); iter != m_Layers.end(); iter++)
+    (*iter)->setVerify(verify);
+}
+
+bool LayeredVolume::isWhiteout(const WideString& name)
+{
+  static const WideString prefix(WHITEOUT_PREFIX);
+  return (name.size() > prefix.size()) && (name.compare(0, prefix.size(), prefix) == 0);
+}
+
+WideString LayeredVolume::getWhiteoutName(const WideString& name)
+{
+  return WideString(WHITEOUT_PREFIX) + name;
+}
+
+void LayeredVolume::resolve()
+{
+  // apply the layers bottom up into an ordered map, so hiding a whole
+  // folder is a single range erase, then flatten that into the index
+  ResolvedPaths paths;
+  for(std::vector<ReadOnlyVolume*>::iterator iter = m_Layers.begin(); iter != m_Layers.end(); iter++)
+  {
+    paths[L""] = *iter;
+    resolveFolder(*iter, L"", paths);
+  }
+
+  m_Index.clear();
+  for(ResolvedPaths::iterator iter = paths.begin(); iter != paths.end(); iter++)
+    m_Index.add(iter->first, iter->second);
+}
+
+void LayeredVolume::resolveFolder(Folder* folder, const WideString& prefix, ResolvedPaths& paths)
+{
+  static const size_t prefixLength = WideString(WHITEOUT_PREFIX).size();
+
+  // whiteouts first, a patch may delete a thing and add it back
+  Files* files = folder->getFiles();
+  for(Entities::iterator iter = files->begin(); iter != files->end(); iter++)
+    if(isWhiteout((*iter)->getName()))
+      hide(prefix + (*iter)->getName().substr(prefixLength), paths);
+
+  for(Entities::iterator iter = files->begin(); iter != files->end(); iter++)
+  {
+    if(isWhiteout((*iter)->getName()))
+      continue;
+
+    WideString path = prefix + (*iter)->getName();
+    ResolvedPaths::iterator existing = paths.find(path);
+    if((existing != paths.end()) && existing->second->isFolder())
+      hide(path, paths);
+    paths[path] = *iter;
+  }
+
+  Folders* folders = folder->getFolders();
+  for(Entities::iterator iter = folders->begin(); iter != folders->end(); iter++)
+  {
+    WideString path = prefix + (*iter)->getName();
+    ResolvedPaths::iterator existing = paths.find(path);
+    if((existing != paths.end()) && !existing->second->isFolder())
+      paths.erase(existing);
+
+    // folders merge with the ones below
+    paths[path] = *iter;
+    resolveFolder(dynamic_cast<Folder*>(*iter), path + PATH_SEPARATOR, paths);
+  }
+}
+
+void LayeredVolume::hide(const WideString& path, ResolvedPaths& paths)
+{
+  paths.erase(path);
+
+  // and everything below it
+  WideString below = path + PATH_SEPARATOR;
+  ResolvedPaths::iterator first = paths.lower_bound(below);
+  ResolvedPaths::iterator last = first;
+  while((last != paths.end()) && (last->first.compare(0, below.size(), below) == 0))
+    last++;
+  paths.erase(first, last);
+}
+
+bool LayeredVolume::folderExists(const WideString& path) const
+{
+  return findFolder(path) != NULL;
+}
+
+bool LayeredVolume::fileExists(const WideString& path) const
+{
+  return findFile(path) != NULL;
+}
+
+const Folder* LayeredVolume::findFolder(const WideChar* path, size_t length) const
+{
+  const Entity* entity = m_Index.find(path, length);
+  return ((entity != NULL) && entity->isFolder()) ? static_cast<const Folder*>(entity) : NULL;
+}
+
+const Folder* LayeredVolume::findFolder(const WideString& path) const
+{
+  return findFolder(path.c_str(), path.size());
+}
+
+const File* LayeredVolume::findFile(const WideChar* path, size_t length) const
+{
+  const Entity* entity = m_Index.find(path, length);
+  return ((entity != NULL) && !entity->isFolder()) ? static_cast<const File*>(entity) : NULL;
+}
+
+const File* LayeredVolume::findFile(const WideString& path) const
+{
+  return findFile(path.c_str(), path.size());
+}
+
+const int LayeredVolume::findLayer(const WideString& path) const
+{
+  const Entity* entity = m_Index.find(path);
+  if(entity == NULL)
+    return -1;
+
+  // the layer is the volume at the top of the entity's owner chain
+  while(entity->getOwner() != NULL)
+    entity = entity->getOwner();
+  for(size_t i = 0; i < m_Layers.size(); i++)
+    if(m_Layers[i] == entity)
+      return (int)i;
+
+  return -1;
+}
@@ -0,0 +1,79 @@
+
+#ifndef GJ_VFS_LAYERED_VOLUME_HEADER
+#define GJ_VFS_LAYERED_VOLUME_HEADER
+
+#include "GjDefs.h"
+#include "GjVFSDefs.h"
+#include "GjVFSFile.h"
+#include "GjVFSFolder.h"
+#include "GjVFSVolume.h"
+#include "GjVFSPathIndex.h"
+
+#include <map>
+
+namespace yaglib
+{
+  namespace vfs
+  {
+
+/**
+ * stacks patch archives over a base archive.  the first archive mounted
+ * is the base, every one after it is a patch over everything mounted
+ * before.  a patch only carries what it adds or replaces, plus whiteouts
+ * (see WHITEOUT_PREFIX) for whatever it deletes; a whiteout on a folder
+ * hides the whole folder, and an entry replacing one of a different
+ * kind hides everything the old one had below it.
+ *
+ * which layer answers for which path is worked out once, whenever a
+ * layer is mounted, so lookups cost the same however many are stacked.
+ * the entities returned belong to the layer providing them; a folder's
+ * own listing only shows that layer's contents.
+ */
+class LayeredVolume : private boost::noncopyable
+{
+public:
+  LayeredVolume();
+  virtual ~LayeredVolume();
+
+  bool mount(const WideString& fileName);
+  void unmountAll();
+
+  const int getLayerCount() const;
+  ReadOnlyVolume* getLayer(const int index) const;
+
+  bool folderExists(const WideString& path) const;
+  bool fileExists(const WideString& path) const;
+
+  const Folder* findFolder(const WideChar* path, size_t length) const;
+  const Folder* findFolder(const WideString& path) const;
+  const File* findFile(const WideChar* path, size_t length) const;
+  const File* findFile(const WideString& path) const;
+
+  // the layer a path is resolved to, or -1 if it isn't there
+  const int findLayer(const WideString& path) const;
+
+  // attaches the files of every layer, including ones mounted later
+  void setCache(DataCache* cache);
+  // and has every layer verify its data, see Volume::setVerify()
+  void setVerify(const bool verify);
+
+  static bool isWhiteout(const WideString& name);
+  static WideString getWhiteoutName(const WideString& name);
+
+private:
+  typedef std::map<WideString, Entity*> ResolvedPaths;
+
+  std::vector<ReadOnlyVolume*> m_Layers;
+  PathIndex m_Index;
+  DataCache* m_Cache;
+  bool m_Verify;
+
+  void resolve();
+  void resolveFolder(Folder* folder, const WideString& prefix, ResolvedPaths& paths);
+  void hide(const WideString& path, ResolvedPaths& paths);
+};
+
+  } /* namespace vfs */
+} /* namespace yaglib */
+
+#endif /* GJ_VFS_LAYERED_VOLUME_HEADER */
@@ -0,0 +1,169 @@
+
+#include "GjVFSMappedFile.h"
+#include "GjThreads.h"
+using namespace yaglib;
+using namespace yaglib::vfs;
+
+typedef std::map<WideString, MappedFile*> MappedFiles;
+
+// volumes come and go on the I/O threads too, so the registry and the
+// reference counts are only touched under this. it's set up during
+// static initialization, before any of those threads exist.
+static CriticalSection mappingsLock;
+
+// all mappings currently alive, keyed by the name they were opened with
+static MappedFiles& openMappings()
+{
+  static MappedFiles mappings;
+  return mappings;
+}
+
+MappedFile::MappedFile(const WideString& fileName) :
+  m_FileName(fileName), m_File(INVALID_HANDLE_VALUE), m_Mapping(NULL),
+  m_Data(NULL), m_Size(0), m_RefCount(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+  unmap();
+}
+
+MappedFile* MappedFile::open(const WideString& fileName)
+{
+  ScopedLock lock(mappingsLock);
+  MappedFiles& mappings = openMappings();
+  MappedFiles::iterator iter = mappings.find(fileName);
+  if(iter != mappings.end())
+  {
+    iter->second->m_RefCount++;
+    return iter->second;
+  }
+
+  MappedFile* mapping = new MappedFile(fileName);
+  if(!mapping->map())
+  {
+    delete mapping;
+    return NULL;
+  }
+
+  mapping->m_RefCount = 1;
+  mappings[fileName] = mapping;
+  return mapping;
+}
+
+void MappedFile::release()
+{
+  {
+    ScopedLock lock(mappingsLock);
+    if(--m_RefCount > 0)
+      return;
+    openMappings().erase(m_FileName);
+  }
+
+  // nobody can find it any more, so unmapping can happen unlocked
+  delete this;
+}
+
+bool MappedFile::map()
+{
+  // random access is the right hint here, the volumes jump
+  // around the file depending on what the game asks for
+  m_File = CreateFile(m_FileName.c_str(), GENERIC_READ, FILE_SHARE_READ,
+    NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+  if(m_File == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER fileSize;
+  if(!GetFileSizeEx(m_File, &fileSize) || (fileSize.QuadPart == 0) ||
+     ((ULONGLONG)fileSize.QuadPart > (ULONGLONG)((size_t)-1)))
+  {
+    unmap();
+    return false;
+  }
+
+  m_Mapping = CreateFileMapping(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+  if(m_Mapping == NULL)
+  {
+    unmap();
+    return false;
+  }
+
+  // nothing is actually read here. the OS faults the pages in
+  // as the data holders touch them.
+  m_Data = (PByte) MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+  if(m_Data == NULL)
+  {
+    unmap();
+    return false;
+  }
+
+  m_Size = (size_t) fileSize.QuadPart;
+  return true;
+}
+
+void MappedFile::unmap()
+{
+  if(m_Data != NULL)
+  {
+    UnmapViewOfFile(m_Data);
+    m_Data = NULL;
+  }
+  if(m_Mapping != NULL)
+  {
+    CloseHandle(m_Mapping);
+    m_Mapping = NULL;
+  }
+  if(m_File != INVALID_HANDLE_VALUE)
+  {
+    CloseHandle(m_File);
+    m_File = INVALID_HANDLE_VALUE;
+  }
+  m_Size = 0;
+}
+
+const PByte MappedFile::getData() const
+{
+  return m_Data;
+}
+
+const size_t MappedFile::getSize() const
+{
+  return m_Size;
+}
+
+const WideString& MappedFile::getFileName() const
+{
+  return m_FileName;
+}
+
+// MemoryStreamBuffer
+MemoryStreamBuffer::MemoryStreamBuffer(const PByte data, size_t size)
+{
+  char* start = (char*) data;
+  setg(start, start, start + size);
+}
+
+MemoryStreamBuffer::pos_type MemoryStreamBuffer::seekoff(off_type offset,
+  std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+  char* target;
+  if(dir == std::ios_base::beg)
+    target = eback() + offset;
+  else if(dir == std::ios_base::cur)
+    target = gptr() + offset;
+  else
+    target = egptr() + offset;
+
+  if((target < eback()) || (target > egptr()))
+    return pos_type(off_type(-1));
+
+  setg(eback(), target, egptr());
+  return pos_type(target - eback());
+}
+
+MemoryStreamBuffer::pos_type MemoryStreamBuffer::seekpos(pos_type position,
+  std::ios_base::openmode which)
+{
+  return seekoff(off_type(position), std::ios_base::beg, which);
+}
@@ -0,0 +1,63 @@
+
+#ifndef GJ_VFS_MAPPED_FILE_HEADER
+#define GJ_VFS_MAPPED_FILE_HEADER
+
+#include "GjDefs.h"
+#include "GjVFSDefs.h"
+
+#include <streambuf>
+
+namespace yaglib
+{
+  namespace vfs
+  {
+
+/**
+ * read-only memory mapping of a whole file.  instances are shared:
+ * opening a file that is already mapped just bumps the reference count
+ * of the existing mapping.  every open() must be paired with a release().
+ * open() and release() may be called from any thread.
+ * pages are only faulted in by the OS when they are actually touched.
+ */
+class MappedFile
+{
+public:
+  static MappedFile* open(const WideString& fileName);
+  void release();
+
+  const PByte getData() const;
+  const size_t getSize() const;
+  const WideString& getFileName() const;
+
+private:
+  MappedFile(const WideString& fileName);
+  ~MappedFile();
+
+  bool map();
+  void unmap();
+
+  WideString m_FileName;
+  HANDLE m_File;
+  HANDLE m_Mapping;
+  PByte m_Data;
+  size_t m_Size;
+  int m_RefCount;
+};
+
+/** lets the std::istream based loaders read straight out of a memory block */
+class MemoryStreamBuffer : public std::streambuf
+{
+public:
+  MemoryStreamBuffer(const PByte data, size_t size);
+
+protected:
+  virtual pos_type seekoff(off_type offset, std::ios_base::seekdir dir,
+    std::ios_base::openmode which = std::ios_base::in);
+  virtual pos_type seekpos(pos_type position,
+    std::ios_base::openmode which = std::ios_base::in);
+};
+
+  } /* namespace vfs */
+} /* namespace yaglib */
+
+#endif /* GJ_VFS_MAPPED_FILE_HEADER */
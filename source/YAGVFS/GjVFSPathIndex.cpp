@@ -0,0 +1,83 @@
+
+#include "GjVFSPathIndex.h"
+#include "GjVFSFolder.h"
+using namespace yaglib;
+using namespace yaglib::vfs;
+
+static inline bool isSeparator(const WideChar c)
+{
+  return (c == '/') || (c == '\\');
+}
+
+PathIndex::PathIndex()
+{
+}
+
+void PathIndex::build(Folder* root)
+{
+  clear();
+  add(L"", root);
+  addFolder(root, L"");
+}
+
+void PathIndex::addFolder(Folder* folder, const WideString& prefix)
+{
+  Folders* folders = folder->getFolders();
+  Files* files = folder->getFiles();
+  m_Index.reserve(m_Entities.size() + folders->size() + files->size());
+
+  for(Entities::iterator iter = files->begin(); iter != files->end(); iter++)
+    add(prefix + (*iter)->getName(), *iter);
+
+  for(Entities::iterator iter = folders->begin(); iter != folders->end(); iter++)
+  {
+    WideString path = prefix + (*iter)->getName();
+    add(path, *iter);
+    addFolder(dynamic_cast<Folder*>(*iter), path + PATH_SEPARATOR);
+  }
+}
+
+void PathIndex::add(const WideString& path, Entity* entity)
+{
+  // same path seen again, the newer entity wins
+  int existing = m_Index.find(path);
+  if(existing != StringIndex<PathChars>::npos)
+  {
+    m_Entities[existing] = entity;
+    return;
+  }
+
+  m_Index.insert(path, (int)m_Entities.size());
+  m_Entities.push_back(entity);
+}
+
+void PathIndex::clear()
+{
+  m_Index.clear();
+  m_Entities.clear();
+}
+
+Entity* PathIndex::find(const WideChar* path, size_t length) const
+{
+  // trim the separators off both ends, the keys never have them
+  while((length > 0) && isSeparator(*path))
+  {
+    path++;
+    length--;
+  }
+  while((length > 0) && isSeparator(path[length-1]))
+    length--;
+
+  int index = m_Index.find(path, length);
+  return (index == StringIndex<PathChars>::npos) ? NULL : m_Entities[index];
+}
+
+Entity* PathIndex::find(const WideString& path) const
+{
+  return find(path.c_str(), path.size());
+}
+
+const size_t PathIndex::size() const
+{
+  return m_Entities.size();
+}
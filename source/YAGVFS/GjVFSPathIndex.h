@@ -0,0 +1,46 @@
+
+#ifndef GJ_VFS_PATH_INDEX_HEADER
+#define GJ_VFS_PATH_INDEX_HEADER
+
+#include "GjDefs.h"
+#include "GjVFSDefs.h"
+#include "GjVFSEntities.h"
+#include "GjStringIndex.h"
+
+namespace yaglib
+{
+  namespace vfs
+  {
+
+class Folder;
+
+/**
+ * flat lookup table from fully qualified paths (relative to the volume,
+ * e.g. "maps/town/ground.map") to the entities they name.  both '/' and
+ * '\' are accepted as separators, and leading or trailing separators
+ * are ignored.  lookups never allocate.
+ */
+class PathIndex
+{
+public:
+  PathIndex();
+
+  void build(Folder* root);
+  void add(const WideString& path, Entity* entity);
+  void clear();
+
+  Entity* find(const WideChar* path, size_t length) const;
+  Entity* find(const WideString& path) const;
+  const size_t size() const;
+
+private:
+  StringIndex<PathChars> m_Index;
+  std::vector<Entity*> m_Entities;
+
+  void addFolder(Folder* folder, const WideString& prefix);
+};
+
+  } /* namespace vfs */
+} /* namespace yaglib */
+
+#endif /* GJ_VFS_PATH_INDEX_HEADER */
@@ -0,0 +1,153 @@
+
+#include "GjVFSPrefetch.h"
+#include <boost/bind.hpp>
+using namespace yaglib;
+using namespace yaglib::vfs;
+
+#define PAGE_STRIDE 4096
+
+// PrefetchBatch
+PrefetchBatch::PrefetchBatch(const int fileCount, PrefetchCallback callback) :
+  m_FileCount(fileCount), m_Completed(0), m_Failed(0), m_Callback(callback)
+{
+  m_Done = CreateEvent(NULL, TRUE, (fileCount == 0) ? TRUE : FALSE, NULL);
+}
+
+PrefetchBatch::~PrefetchBatch()
+{
+  CloseHandle(m_Done);
+}
+
+const bool PrefetchBatch::isComplete() const
+{
+  return m_Completed == m_FileCount;
+}
+
+const int PrefetchBatch::getFileCount() const
+{
+  return m_FileCount;
+}
+
+const int PrefetchBatch::getCompletedCount() const
+{
+  return m_Completed;
+}
+
+const int PrefetchBatch::getFailedCount() const
+{
+  return m_Failed;
+}
+
+bool PrefetchBatch::wait(const DWORD timeout)
+{
+  return WaitForSingleObject(m_Done, timeout) == WAIT_OBJECT_0;
+}
+
+void PrefetchBatch::fileDone(const bool loaded, PrefetchTicket self)
+{
+  if(!loaded)
+    InterlockedIncrement(&m_Failed);
+
+  // the last one out signals everyone
+  if(InterlockedIncrement(&m_Completed) == m_FileCount)
+  {
+    SetEvent(m_Done);
+    if(m_Callback)
+      m_Callback(self);
+  }
+}
+
+// Prefetcher
+Prefetcher::Prefetcher(Volume* volume, const int workerCount) :
+  m_Volume(volume), m_Workers(workerCount)
+{
+}
+
+Prefetcher::~Prefetcher()
+{
+  // let the queued loads finish, so every ticket handed out completes
+  m_Workers.wait();
+}
+
+PrefetchTicket Prefetcher::prefetch(Folder* folder, const bool recursive, PrefetchCallback callback)
+{
+  std::vector<File*> files;
+  if(folder != NULL)
+    collect(folder, recursive, files);
+
+  return schedule(files, callback);
+}
+
+PrefetchTicket Prefetcher::prefetch(const std::vector<WideString>& paths, PrefetchCallback callback)
+{
+  std::vector<File*> files;
+  for(std::vector<WideString>::const_iterator iter = paths.begin(); iter != paths.end(); iter++)
+  {
+    File* file = const_cast<File*>(m_Volume->findFile(*iter));
+    if(file != NULL)
+      files.push_back(file);
+  }
+
+  return schedule(files, callback);
+}
+
+void Prefetcher::waitAll()
+{
+  m_Workers.wait();
+}
+
+void Prefetcher::collect(Folder* folder, const bool recursive, std::vector<File*>& files)
+{
+  Files* list = folder->getFiles();
+  for(Entities::iterator iter = list->begin(); iter != list->end(); iter++)
+    files.push_back(dynamic_cast<File*>(*iter));
+
+  if(!recursive)
+    return;
+
+  Folders* folders = folder->getFolders();
+  for(Entities::iterator iter = folders->begin(); iter != folders->end(); iter++)
+    collect(dynamic_cast<Folder*>(*iter), recursive, files);
+}
+
+static bool byOffset(File* a, File* b)
+{
+  return a->getDataHolder()->getOffset() < b->getDataHolder()->getOffset();
+}
+
+PrefetchTicket Prefetcher::schedule(std::vector<File*>& files, PrefetchCallback callback)
+{
+  // queue them in archive order, so the reads mostly move forward
+  std::sort(files.begin(), files.end(), byOffset);
+
+  PrefetchTicket ticket(new PrefetchBatch((int)files.size(), callback));
+  for(std::vector<File*>::iterator iter = files.begin(); iter != files.end(); iter++)
+    m_Workers.submit(boost::bind(&Prefetcher::loadFile, *iter, ticket));
+
+  if(files.empty() && callback)
+    callback(ticket);
+
+  return ticket;
+}
+
+void Prefetcher::loadFile(File* file, PrefetchTicket ticket)
+{
+  // pinned while we look at it, so the data isn't kept around for
+  // unpinned readers when it goes cold
+  DataHolder* holder = file->getDataHolder();
+  DataCache* cache = holder->getCache();
+  const PByte data = (cache != NULL) ? cache->acquire(holder) : holder->getData();
+
+  // data we don't own lives in a mapping, and has not been read yet.
+  // touch every page so it's resident before the game asks for it.
+  if((data != NULL) && !holder->isDataOwned())
+  {
+    volatile Byte sink = 0;
+    for(size_t i = 0; i < holder->getDataSize(); i += PAGE_STRIDE)
+      sink ^= data[i];
+  }
+
+  if(cache != NULL)
+    cache->release(holder);
+  ticket->fileDone(data != NULL, ticket);
+}
@@ -0,0 +1,83 @@
+
+#ifndef GJ_VFS_PREFETCH_HEADER
+#define GJ_VFS_PREFETCH_HEADER
+
+#include "GjDefs.h"
+#include "GjVFSDefs.h"
+#include "GjVFSFile.h"
+#include "GjVFSFolder.h"
+#include "GjVFSVolume.h"
+#include "GjThreads.h"
+
+#include <boost/shared_ptr.hpp>
+
+namespace yaglib
+{
+  namespace vfs
+  {
+
+class PrefetchBatch;
+typedef boost::shared_ptr<PrefetchBatch> PrefetchTicket;
+typedef boost::function<void (PrefetchTicket)> PrefetchCallback;
+
+/**
+ * tracks one prefetch request.  poll isComplete() once a frame, or
+ * wait() for it.  the files' data holders are loaded by the time the
+ * batch completes, so getData() on them will not touch the disk.
+ */
+class PrefetchBatch : private boost::noncopyable
+{
+public:
+  PrefetchBatch(const int fileCount, PrefetchCallback callback);
+  ~PrefetchBatch();
+
+  const bool isComplete() const;
+  const int getFileCount() const;
+  const int getCompletedCount() const;
+  const int getFailedCount() const;
+
+  bool wait(const DWORD timeout = INFINITE);
+
+private:
+  friend class Prefetcher;
+
+  int m_FileCount;
+  volatile LONG m_Completed;
+  volatile LONG m_Failed;
+  HANDLE m_Done;
+  PrefetchCallback m_Callback;
+
+  void fileDone(const bool loaded, PrefetchTicket self);
+};
+
+/**
+ * loads files ahead of time on a pool of worker threads.  the volume
+ * must outlive the prefetcher.
+ */
+class Prefetcher
+{
+public:
+  Prefetcher(Volume* volume, const int workerCount = 0);
+  virtual ~Prefetcher();
+
+  PrefetchTicket prefetch(Folder* folder, const bool recursive = true, 
+    PrefetchCallback callback = PrefetchCallback());
+  PrefetchTicket prefetch(const std::vector<WideString>& paths,
+    PrefetchCallback callback = PrefetchCallback());
+
+  void waitAll();
+
+private:
+  Volume* m_Volume;
+  WorkerPool m_Workers;
+
+  void collect(Folder* folder, const bool recursive, std::vector<File*>& files);
+  PrefetchTicket schedule(std::vector<File*>& files, PrefetchCallback callback);
+
+  static void loadFile(File* file, PrefetchTicket ticket);
+};
+
+  } /* namespace vfs */
+} /* namespace yaglib */
+
+#endif /* GJ_VFS_PREFETCH_HEADER */
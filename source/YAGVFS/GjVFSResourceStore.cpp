@@ -0,0 +1,81 @@
+
+#include "GjVFSResourceStore.h"
+using namespace yaglib;
+using namespace yaglib::vfs;
+
+// what a data pack holds on to while it points into the volume
+class VolumeData
+{
+public:
+  VolumeData(const boost::shared_ptr<ReadOnlyVolume>& volume, DataHolder* holder, DataCache* cache) :
+    m_Volume(volume), m_Holder(holder), m_Cache(cache)
+  { };
+  void operator()(void* data)
+  { if(m_Cache != NULL) m_Cache->release(m_Holder); };
+private:
+  boost::shared_ptr<ReadOnlyVolume> m_Volume;
+  DataHolder* m_Holder;
+  DataCache* m_Cache;
+};
+
+VolumeStore::VolumeStore(const WideString& pathName) : 
+  ResourceStore(pathName), m_Volume(new ReadOnlyVolume())
+{
+  if(!m_Volume->mount(pathName))
+    throw std::exception("Resource archive can not be mounted");
+}
+
+VolumeStore::~VolumeStore()
+{
+}
+
+bool VolumeStore::lookup(DataPack& dataPack, const WideString fileName, const bool fileNameOnly)
+{
+  const File* file = m_Volume->findFile(fileName);
+  if(file == NULL)
+    return false;
+
+  dataPack.setFileName(getPathName() + L"\\" + fileName);
+  if(!fileNameOnly)
+  {
+    // the volume keeps the data, mapped or unpacked, for as long as it's
+    // mounted. with a cache, it also has to be kept from being evicted.
+    DataHolder* holder = file->getDataHolder();
+    DataCache* cache = m_Volume->getCache();
+    PByte data = (cache != NULL) ? cache->acquire(holder) : holder->getData();
+    if((data == NULL) && (holder->getDataSize() > 0))
+    {
+      if(cache != NULL)
+        cache->release(holder);
+      return false;
+    }
+    dataPack.setData(DataPack::Buffer(data, VolumeData(m_Volume, holder, cache)),
+      data, holder->getDataSize());
+  }
+
+  return true;
+}
+
+bool VolumeStore::hasDiskPaths() const
+{
+  return false;
+}
+
+void VolumeStore::update()
+{
+  // it's between frames, nobody should be holding on to data they
+  // got without a pin any more
+  DataCache* cache = m_Volume->getCache();
+  if(cache != NULL)
+    cache->reclaim();
+}
+
+ReadOnlyVolume& VolumeStore::getVolume()
+{
+  return *m_Volume;
+}
+
+ResourceStore* VolumeStore::create(const WideString& pathName)
+{
+  return new VolumeStore(pathName);
+}
@@ -0,0 +1,58 @@
+
+#ifndef GJ_VFS_RESOURCE_STORE_HEADER
+#define GJ_VFS_RESOURCE_STORE_HEADER
+
+#include "GjDefs.h"
+#include "GjResourceManagement.h"
+#include "GjVFSVolume.h"
+
+#include <boost/shared_ptr.hpp>
+
+namespace yaglib
+{
+  namespace vfs
+  {
+
+// the extension archives are registered under with the resource manager
+#define VFS_ARCHIVE_EXTENSION L".vfs"
+
+/**
+ * serves resources out of a mounted archive.  lookups go through the
+ * volume's index or table of contents, never the file system, and the
+ * data packs handed out point straight at the volume's data instead of
+ * a copy.  a pack keeps the volume mounted, and its data pinned in the
+ * volume's cache, for as long as it is around; the store may go first.
+ *
+ * archives have no file names for what's in them, so lookups that only
+ * want the name get the archive's path with the resource's appended.
+ * that is enough to tell it's there, but not to open it from disk, and
+ * ResourceManager::operator[] passes archives over.  fonts and sounds,
+ * which are opened by file name, have to stay in resource folders.
+ *
+ * register it with the resource manager before initialize():
+ *   g_ResourceManager.registerStore(VFS_ARCHIVE_EXTENSION, &VolumeStore::create);
+ */
+class VolumeStore : public ResourceStore
+{
+public:
+  VolumeStore(const WideString& pathName);
+  virtual ~VolumeStore();
+
+  virtual bool lookup(DataPack& dataPack, const WideString fileName, const bool fileNameOnly = false);
+  virtual bool hasDiskPaths() const;
+  // frees what the volume's cache evicted from under unpinned readers
+  virtual void update();
+
+  ReadOnlyVolume& getVolume();
+
+  // a StoreFactory for the resource manager
+  static ResourceStore* create(const WideString& pathName);
+
+private:
+  boost::shared_ptr<ReadOnlyVolume> m_Volume;
+};
+
+  } /* namespace vfs */
+} /* namespace yaglib */
+
+#endif /* GJ_VFS_RESOURCE_STORE_HEADER */
@@ -1,16 +1,74 @@
 
 #include "GjVFSVolume.h"
-#include "GjUtils.h"
 #include "GjUnicodeUtils.h"
+#include "GjBFS.h"
 using namespace yaglib;
 using namespace yaglib::vfs;
 
-Volume::Volume() : Folder(PATH_SEPARATOR, NULL)
+static inline bool isSeparator(const WideChar c)
+{
+  return (c == '/') || (c == '\\');
+}
+
+static void splitPath(const WideString& path, std::vector<WideString>& names)
+{
+  size_t start = 0;
+  for(size_t i = 0; i <= path.size(); i++)
+  {
+    if((i == path.size()) || isSeparator(path[i]))
+    {
+      if(i > start)
+        names.push_back(path.substr(start, i - start));
+      start = i + 1;
+    }
+  }
+}
+
+// moves everything in source over to dest, keeping the order
+static void moveContents(Folder* source, Folder* dest)
+{
+  std::vector<Entity*> entities(source->getFolders()->begin(), source->getFolders()->end());
+  entities.insert(entities.end(), source->getFiles()->begin(), source->getFiles()->end());
+  for(std::vector<Entity*>::iterator iter = entities.begin(); iter != entities.end(); iter++)
+  {
+    source->detach(*iter, false);
+    dest->attach(*iter);
+  }
+}
+
+// reads and validates the header, handling the shorter older ones,
+// and leaves the stream at the start of the structures
+static bool readHeader(std::istream& source, VFS_HEADER& header)
+{
+  memset(&header, 0, sizeof(VFS_HEADER));
+  source.read((char*)&header, cOriginalHeaderSize);
+  if(!source.good() || (memcmp(header.signature, cDefSignature, sizeof(cDefSignature)) != 0) ||
+     (header.headerSize < cOriginalHeaderSize))
+    return false;
+
+  // whatever this version knows of the rest of it
+  int known = (header.headerSize < (int)sizeof(VFS_HEADER)) ? header.headerSize : (int)sizeof(VFS_HEADER);
+  if(known > cOriginalHeaderSize)
+    source.read((char*)&header + cOriginalHeaderSize, known - cOriginalHeaderSize);
+
+  if(header.headerSize < cCompressedHeaderSize)
+    header.version = cVersionOriginal;
+
+  if(header.version > cCurrentVersion)
+    return false;
+
+  source.seekg(header.folderOffset, std::ios::beg);
+  return source.good();
+}
+
+Volume::Volume() : Folder(PATH_SEPARATOR, NULL), m_Indexed(false),
+  m_Cache(NULL), m_Verify(false), m_FlatToc(NULL)
 {
 }
 
 Volume::~Volume()
 {
+  dropToc();
 }
 
 Folder* Volume::getFolder(std::vector<WideString>& names, bool forceCreate)
@@ -25,7 +83,9 @@ Folder* Volume::getFolder(std::vector<WideString>& names, bool forceCreate)
     if(subFolder == NULL)
     {
       if(!forceCreate) return NULL;
+      releaseToc();
       subFolder = folder->createFolder(*iter);
+      dropIndex();
     }
 
     folder = subFolder;
@@ -36,15 +96,12 @@ Folder* Volume::getFolder(std::vector<WideString>& names, bool forceCreate)
 
 bool Volume::folderExists(WideString& path)
 {
-  std::vector<WideString> names;
-  WideStringUtils::splitPath(path, names);
-
-  return getFolder(names, false) != NULL;
+  return findFolder(path) != NULL;
 }
 
 bool Volume::fileExists(WideString& path)
 {
-  return getFile(path, false) != NULL;
+  return findFile(path) != NULL;
 }
 
 Entity* Volume::add(WideString& path, WideString& pathToFile)
@@ -64,33 +121,41 @@ Entity* Volume::add(WideString& path, Byte* buf, unsigned int bufSize)
 
 Folder* Volume::getFolder(WideString& path, bool forceCreate)
 {
+  Folder* folder = const_cast<Folder*>(findFolder(path));
+  if((folder != NULL) || !forceCreate)
+    return folder;
+
   std::vector<WideString> names;
-  WideStringUtils::splitPath(path, names);
+  splitPath(path, names);
   return getFolder(names, forceCreate);
 }
 
 File* Volume::getFile(WideString& path, bool forceCreate)
 {
-  std::vector<WideString> names;
-  WideStringUtils::splitPath(path, names);
-  WideString fileName = names[names.size()-1];
-  names.erase(names.end()-1);
+  File* theFile = const_cast<File*>(findFile(path));
+  if((theFile == NULL) && forceCreate)
+  {
+    std::vector<WideString> names;
+    splitPath(path, names);
+    WideString fileName = names[names.size()-1];
+    names.erase(names.end()-1);
 
-  Folder* folder = getFolder(names, forceCreate);
-  if(folder == NULL)
-    return NULL;
+    Folder* folder = getFolder(names, forceCreate);
+    if(folder == NULL)
+      return NULL;
 
-  Files* list = folder->getFiles();
-  File* theFile = dynamic_cast<File*>(list->find(fileName));
-  if((theFile == NULL) && forceCreate)
+    releaseToc();
     theFile = folder->createFile(fileName);
+    theFile->getDataHolder()->setCache(m_Cache);
+    dropIndex();
+  }
 
   // if there is indeed a file, we should check the override path
   // in case there is an override file for this one
   if((NULL != theFile) && (m_OverridePath.size() > 0))
   {
     WideString qualifiedPath = m_OverridePath + path;
-    if(OSFiles::Exists(const_cast<TCHAR*>(qualifiedPath.c_str())))
+    if(bfs::exists(qualifiedPath))
     {
       theFile->getDataHolder()->assign(qualifiedPath);
     }
@@ -109,6 +174,172 @@ void Volume::setOverridePath(WideString& path)
   m_OverridePath = path;
 }
 
+void Volume::buildIndex()
+{
+  m_Index.build(this);
+  m_Indexed = true;
+}
+
+void Volume::dropIndex()
+{
+  m_Index.clear();
+  m_Indexed = false;
+}
+
+const bool Volume::hasIndex() const
+{
+  return m_Indexed;
+}
+
+void Volume::setCache(DataCache* cache)
+{
+  m_Cache = cache;
+  if(m_FlatToc != NULL)
+    m_FlatToc->attachCache(m_Cache);
+  else
+    attachCache(this);
+}
+
+DataCache* Volume::getCache() const
+{
+  return m_Cache;
+}
+
+void Volume::setVerify(const bool verify)
+{
+  m_Verify = verify;
+  if(m_FlatToc != NULL)
+    m_FlatToc->setVerify(m_Verify);
+  else
+    applyVerify(this);
+}
+
+const bool Volume::getVerify() const
+{
+  return m_Verify;
+}
+
+void Volume::applyVerify(Folder* folder)
+{
+  Folders* folders = folder->getFolders();
+  for(Entities::iterator iter = folders->begin(); iter != folders->end(); iter++)
+    applyVerify(dynamic_cast<Folder*>(*iter));
+
+  Files* files = folder->getFiles();
+  for(Entities::iterator iter = files->begin(); iter != files->end(); iter++)
+    dynamic_cast<File*>(*iter)->getDataHolder()->setVerify(m_Verify);
+}
+
+void Volume::attachCache(Folder* folder)
+{
+  Folders* folders = folder->getFolders();
+  for(Entities::iterator iter = folders->begin(); iter != folders->end(); iter++)
+    attachCache(dynamic_cast<Folder*>(*iter));
+
+  Files* files = folder->getFiles();
+  for(Entities::iterator iter = files->begin(); iter != files->end(); iter++)
+    dynamic_cast<File*>(*iter)->getDataHolder()->setCache(m_Cache);
+}
+
+void Volume::releaseToc()
+{
+  if(m_FlatToc == NULL)
+    return;
+
+  m_FlatToc->populateAll();
+  dropToc();
+}
+
+void Volume::dropToc()
+{
+  delete m_FlatToc;
+  m_FlatToc = NULL;
+}
+
+void Volume::shareDuplicates()
+{
+  std::map<FileOffset, DataHolder*> seen;
+  shareDuplicates(this, seen);
+}
+
+void Volume::shareDuplicates(Folder* folder, std::map<FileOffset, DataHolder*>& seen)
+{
+  Folders* folders = folder->getFolders();
+  for(Entities::iterator iter = folders->begin(); iter != folders->end(); iter++)
+    shareDuplicates(dynamic_cast<Folder*>(*iter), seen);
+
+  Files* files = folder->getFiles();
+  for(Entities::iterator iter = files->begin(); iter != files->end(); iter++)
+  {
+    DataHolder* holder = dynamic_cast<File*>(*iter)->getDataHolder();
+    if(holder->getStoredSize() == 0)
+      continue;
+
+    std::map<FileOffset, DataHolder*>::iterator first = seen.find(holder->getOffset());
+    if(first == seen.end())
+      seen[holder->getOffset()] = holder;
+    else if((first->second->getStoredSize() == holder->getStoredSize()) &&
+            (first->second->getCodec() == holder->getCodec()))
+      holder->shareWith(first->second);
+  }
+}
+
+const Entity* Volume::findEntity(const WideChar* path, size_t length) const
+{
+  if(m_Indexed)
+    return m_Index.find(path, length);
+
+  // the table finds it without creating anything but the entity itself
+  if(m_FlatToc != NULL)
+    return m_FlatToc->materialize(m_FlatToc->find(path, length));
+
+  // no index, walk the tree one path element at a time
+  const Entity* entity = this;
+  size_t start = 0;
+  for(size_t i = 0; i <= length; i++)
+  {
+    if((i < length) && !isSeparator(path[i]))
+      continue;
+
+    if(i > start)
+    {
+      if((entity == NULL) || !entity->isFolder())
+        return NULL;
+
+      WideString name(path + start, i - start);
+      const Folder* folder = static_cast<const Folder*>(entity);
+      entity = folder->getFolders()->find(name);
+      if(entity == NULL)
+        entity = folder->getFiles()->find(name);
+    }
+    start = i + 1;
+  }
+
+  return entity;
+}
+
+const Folder* Volume::findFolder(const WideChar* path, size_t length) const
+{
+  const Entity* entity = findEntity(path, length);
+  return ((entity != NULL) && entity->isFolder()) ? static_cast<const Folder*>(entity) : NULL;
+}
+
+const Folder* Volume::findFolder(const WideString& path) const
+{
+  return findFolder(path.c_str(), path.size());
+}
+
+const File* Volume::findFile(const WideChar* path, size_t length) const
+{
+  const Entity* entity = findEntity(path, length);
+  return ((entity != NULL) && !entity->isFolder()) ? static_cast<const File*>(entity) : NULL;
+}
+
+const File* Volume::findFile(const WideString& path) const
+{
+  return findFile(path.c_str(), path.size());
+}
+
 
 bool ReadWriteVolume::saveToFile(WideString& fileName)
 {
@@ -119,23 +350,31 @@ bool ReadWriteVolume::saveToFile(WideString& fileName)
 
   // write the header
   VFS_HEADER vfsHeader;
+  memset(&vfsHeader, 0, sizeof(VFS_HEADER));
   strcpy(vfsHeader.signature, cDefSignature);
+  vfsHeader.version = cCurrentVersion;
   vfsHeader.headerSize = sizeof(VFS_HEADER);
   vfsHeader.folderOffset = vfsHeader.headerSize;
-  vfsHeader.dataOffset = getIdSize() + vfsHeader.headerSize + 1;
+  vfsHeader.alignment = cBlobAlignment;
+  releaseToc();
+  prepareData();
+  vfsHeader.dataOffset = (int)alignOffset(FlatToc::measure(this) + vfsHeader.headerSize, cBlobAlignment);
   dest.write((char*) &vfsHeader, sizeof(VFS_HEADER));
 
-  // save the structures
-  int offset = vfsHeader.dataOffset;
-  saveId(dest, offset);
+  // save the structures, as a single table
+  FlatToc::write(dest, this, vfsHeader.dataOffset);
+
+  // dataOffset is the next aligned spot after the structures
+  File::alignData(dest);
 
   // save the data itself
   saveData(dest);
+  releasePreparedData();
 
-  return false;
+  return dest.good();
 }
 
-bool ReadWriteVolume::loadFromFile(WideString& fileName)
+bool ReadWriteVolume::loadFromFile(WideString& fileName, const bool demandLoad)
 {
   // open the source file, bail out if it's not opened
   UTF8String utf8(fileName);
@@ -144,52 +383,180 @@ bool ReadWriteVolume::loadFromFile(WideString& fileName)
 
   // load the header
   VFS_HEADER vfsHeader;
-  source.read((char*)&vfsHeader, sizeof(VFS_HEADER));
+  if(!readHeader(source, vfsHeader))
+    return false;
+
+  // everything that can fail is done before we let go of what we have,
+  // so a failed reload leaves the volume as it was
+  FlatToc* toc = NULL;
+  Folder loaded(PATH_SEPARATOR, NULL);
+  if(vfsHeader.version >= cVersionFlatToc)
+  {
+    // the whole table comes in with a single read
+    toc = new FlatToc(this);
+    if(!toc->load(source, vfsHeader.dataOffset - vfsHeader.folderOffset))
+    {
+      delete toc;
+      return false;
+    }
+  }
+  else
+  {
+    loaded.loadId(source, vfsHeader.version);
+    if(source.fail())
+    {
+      loaded.clear();
+      return false;
+    }
+  }
+
+  // load the data now, or keep the archive around to load it later
+  HANDLE dataSource = INVALID_HANDLE_VALUE;
+  if(demandLoad)
+  {
+    dataSource = CreateFile(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ,
+      NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+    if(dataSource == INVALID_HANDLE_VALUE)
+    {
+      delete toc;
+      loaded.clear();
+      return false;
+    }
+  }
+  else
+  {
+    // the tree is built in full and loaded before it replaces anything,
+    // so a short read leaves the volume as it was too
+    if(toc != NULL)
+    {
+      toc->populateInto(&loaded);
+      delete toc;
+      toc = NULL;
+    }
+    else
+    {
+      std::map<FileOffset, DataHolder*> seen;
+      shareDuplicates(&loaded, seen);
+    }
+
+    BatchLoader batch(fileName);
+    batch.add(&loaded);
+    int fileCount = batch.getFileCount();
+    if(!batch.isOpen() || (batch.load() != fileCount))
+    {
+      loaded.clear();
+      return false;
+    }
+  }
 
-  // make sure to clear whatever we currently have
+  // out with the old
+  closeSource();
+  dropIndex();
   clear();
+  dropToc();
+  m_Source = dataSource;
 
-  // load the structures
-  loadId(source);
+  if(toc != NULL)
+  {
+    m_FlatToc = toc;
+    setPending(m_FlatToc, 0);
+  }
+  else
+  {
+    moveContents(&loaded, this);
 
-  // load the data, maybe not?
-  loadFileData(this, source);
+    // entries written once for several paths are loaded once. the
+    // loaded ones are shared already.
+    if(demandLoad)
+      shareDuplicates();
+  }
+  setFileName(fileName);
 
-  // trigger name updates across the board
+  // trigger name updates across the board. with the table around,
+  // it does the lookups and the entities are created as needed
   nameChanged();
+  if(m_FlatToc == NULL)
+  {
+    buildIndex();
+    attachCache(this);
+  }
 
-  return false;
+  return true;
 }
 
-void ReadWriteVolume::loadFileData(Folder* folder, std::ifstream& source)
+int ReadWriteVolume::loadBatch(const std::vector<WideString>& paths)
 {
-  Folders* folders = folder->getFolders();
-  for(Entities::iterator iter = folders->begin(); iter != folders->end(); iter++)
-    loadFileData(dynamic_cast<Folder*>(*iter), source);
+  BatchLoader batch(m_FileName);
+  for(std::vector<WideString>::const_iterator iter = paths.begin(); iter != paths.end(); iter++)
+  {
+    File* file = const_cast<File*>(findFile(*iter));
+    if(file != NULL)
+      batch.add(file);
+  }
 
-  Files* files = folder->getFiles();
-  for(Entities::iterator iter = files->begin(); iter != files->end(); iter++)
-    loadFileData(dynamic_cast<File*>(*iter), source);
+  return batch.load();
 }
 
-void ReadWriteVolume::loadFileData(File* file, std::ifstream& source)
+int ReadWriteVolume::loadBatch(Folder* folder, const bool recursive)
 {
-  DataHolder* holder = const_cast<DataHolder*>(file->getDataHolder());
-  int offset = holder->getOffset();
-  size_t size = holder->getDataSize();
-  char* data = new char[size];
+  BatchLoader batch(m_FileName);
+  batch.add(folder, recursive);
+  return batch.load();
+}
 
-  source.seekg(offset, std::ios::beg);
-  source.read(data, size);
-  holder->assign((PByte)data, size, true);
+PByte ReadWriteVolume::Load(FileOffset offset, size_t size)
+{
+  if(m_Source == INVALID_HANDLE_VALUE)
+    return NULL;
+
+  PByte data = new Byte [size];
+  if(!Read(offset, size, data))
+  {
+    delete [] data;
+    return NULL;
+  }
+
+  return data;
+}
+
+bool ReadWriteVolume::Read(FileOffset offset, size_t size, PByte dest)
+{
+  if(m_Source == INVALID_HANDLE_VALUE)
+    return false;
+
+  // positioned reads don't share a file pointer, so loader threads
+  // can all read through the same handle at once
+  OVERLAPPED position;
+  ZeroMemory(&position, sizeof(OVERLAPPED));
+  position.Offset = (DWORD)(offset & 0xFFFFFFFF);
+  position.OffsetHigh = (DWORD)(offset >> 32);
+
+  DWORD bytesRead = 0;
+  return ReadFile(m_Source, dest, (DWORD)size, &bytesRead, &position) && (bytesRead == size);
+}
+
+bool ReadWriteVolume::CanLoad()
+{
+  return m_Source != INVALID_HANDLE_VALUE;
+}
+
+void ReadWriteVolume::closeSource()
+{
+  if(m_Source != INVALID_HANDLE_VALUE)
+  {
+    CloseHandle(m_Source);
+    m_Source = INVALID_HANDLE_VALUE;
+  }
 }
 
-ReadWriteVolume::ReadWriteVolume() : Volume(), m_FileName(L"")
+ReadWriteVolume::ReadWriteVolume() : Volume(), m_FileName(L""), 
+  m_Source(INVALID_HANDLE_VALUE)
 {
 }
 
 ReadWriteVolume::~ReadWriteVolume()
 {
+  closeSource();
 }
 
 void ReadWriteVolume::setFileName(WideString& fileName)
@@ -202,3 +569,133 @@ const WideString& ReadWriteVolume::getFileName() const
   return m_FileName;
 }
 
+
+
+// ReadOnlyVolume
+ReadOnlyVolume::ReadOnlyVolume() : Volume(), m_Mapping(NULL)
+{
+}
+
+ReadOnlyVolume::~ReadOnlyVolume()
+{
+  unmount();
+}
+
+bool ReadOnlyVolume::mount(const WideString& fileName)
+{
+  // whatever is mounted now stays, unless the new one mounts fine
+  MappedFile* mapping = MappedFile::open(fileName);
+  if(mapping == NULL)
+    return false;
+
+  // the header and structures are parsed straight out of the mapping
+  MemoryStreamBuffer buffer(mapping->getData(), mapping->getSize());
+  std::istream source(&buffer);
+
+  VFS_HEADER vfsHeader;
+  if(!readHeader(source, vfsHeader))
+  {
+    mapping->release();
+    return false;
+  }
+
+  if(vfsHeader.version >= cVersionFlatToc)
+  {
+    // the table is used in place, and checked as a whole up front
+    FlatToc* toc = new FlatToc(this, mapping->getData(), mapping->getSize());
+    if((vfsHeader.folderOffset < 0) || (vfsHeader.dataOffset < vfsHeader.folderOffset) ||
+       ((size_t)vfsHeader.dataOffset > mapping->getSize()) ||
+       !toc->open(mapping->getData() + vfsHeader.folderOffset,
+         vfsHeader.dataOffset - vfsHeader.folderOffset))
+    {
+      delete toc;
+      mapping->release();
+      return false;
+    }
+
+    unmount();
+    m_Mapping = mapping;
+    m_FlatToc = toc;
+    setPending(m_FlatToc, 0);
+    nameChanged();
+    return true;
+  }
+
+  Folder loaded(PATH_SEPARATOR, NULL);
+  loaded.loadId(source, vfsHeader.version);
+  if(source.fail() || !referenceFileData(&loaded, mapping))
+  {
+    loaded.clear();
+    mapping->release();
+    return false;
+  }
+
+  unmount();
+  m_Mapping = mapping;
+  moveContents(&loaded, this);
+  shareDuplicates();
+
+  // trigger name updates across the board
+  nameChanged();
+  buildIndex();
+  attachCache(this);
+
+  return true;
+}
+
+void ReadOnlyVolume::unmount()
+{
+  // the data holders point into the mapping, so they must go first
+  dropIndex();
+  clear();
+  dropToc();
+
+  if(m_Mapping != NULL)
+  {
+    m_Mapping->release();
+    m_Mapping = NULL;
+  }
+}
+
+bool ReadOnlyVolume::referenceFileData(Folder* folder, MappedFile* mapping)
+{
+  Folders* folders = folder->getFolders();
+  for(Entities::iterator iter = folders->begin(); iter != folders->end(); iter++)
+    if(!referenceFileData(dynamic_cast<Folder*>(*iter), mapping))
+      return false;
+
+  Files* files = folder->getFiles();
+  for(Entities::iterator iter = files->begin(); iter != files->end(); iter++)
+    if(!referenceFileData(dynamic_cast<File*>(*iter), mapping))
+      return false;
+
+  return true;
+}
+
+bool ReadOnlyVolume::referenceFileData(File* file, MappedFile* mapping)
+{
+  DataHolder* holder = file->getDataHolder();
+  FileOffset offset = holder->getOffset();
+  FileOffset size = (FileOffset)holder->getStoredSize();
+  FileOffset mappedSize = (FileOffset)mapping->getSize();
+
+  // reject anything that points outside the archive
+  if((offset < 0) || (offset > mappedSize) || (size > mappedSize - offset))
+    return false;
+
+  // unpacked data is referenced as-is, packed data is expanded
+  // the first time someone asks for it
+  holder->referenceStored(mapping->getData() + (size_t)offset);
+  return true;
+}
+
+const bool ReadOnlyVolume::isMounted() const
+{
+  return m_Mapping != NULL;
+}
+
+const WideString& ReadOnlyVolume::getFileName() const
+{
+  static const WideString noFileName(L"");
+  return (m_Mapping != NULL) ? m_Mapping->getFileName() : noFileName;
+}
@@ -7,14 +7,29 @@
 #include "GjVFSEntities.h"
 #include "GjVFSFile.h"
 #include "GjVFSFolder.h"
+#include "GjVFSMappedFile.h"
+#include "GjVFSDataCache.h"
+#include "GjVFSPathIndex.h"
+#include "GjVFSFlatToc.h"
+#include "GjVFSBatchLoad.h"
 
 #include <fstream>
+#include <map>
 
 namespace yaglib
 {
   namespace vfs
   {
 
+/**
+ * a folder tree, saved to and loaded from archives.  once loaded or
+ * mounted, any number of threads may look things up and read file data
+ * at once: nothing on that path writes to shared state except loading
+ * a file's data (published atomically, see DataHolder), filling in a
+ * folder of a flat table of contents (done once, under the table's
+ * lock) and the cache's bookkeeping (under the cache's lock).  editing
+ * the tree, or changing its settings, must not race with any of that.
+ */
 class Volume : public Folder
 {
 public:
@@ -33,8 +48,57 @@ public:
   WideString& getOverridePath();
   void setOverridePath(WideString& path);
 
+  // the path index makes the lookups below O(1).  it is built when a
+  // volume is loaded or mounted, and dropped whenever the volume itself
+  // creates entries.  call buildIndex() again after editing the tree.
+  // volumes with a flat table of contents don't need one, the table
+  // hashes its own paths.
+  void buildIndex();
+  void dropIndex();
+  const bool hasIndex() const;
+
+  // these never create anything, and never touch the override path
+  const Folder* findFolder(const WideChar* path, size_t length) const;
+  const Folder* findFolder(const WideString& path) const;
+  const File* findFile(const WideChar* path, size_t length) const;
+  const File* findFile(const WideString& path) const;
+
+  // attaches every file's data holder, including ones loaded or created
+  // later, to the cache. the cache must outlive the volume's files.
+  void setCache(DataCache* cache);
+  DataCache* getCache() const;
+
+  // with verification on, each file's stored data is checked against
+  // the checksum in the archive the first time it's loaded, and a file
+  // that fails has no data. archives older than the checksums, and data
+  // that didn't come from the archive, are never checked.
+  void setVerify(const bool verify);
+  const bool getVerify() const;
+
 protected:
   WideString m_OverridePath;
+  PathIndex m_Index;
+  bool m_Indexed;
+  DataCache* m_Cache;
+  bool m_Verify;
+  FlatToc* m_FlatToc;
+
+  void attachCache(Folder* folder);
+  void applyVerify(Folder* folder);
+
+  // with a flat table of contents, lookups go through the table and the
+  // tree is only built as far as it's used. anything that changes the
+  // tree has it built in full first (releaseToc); dropToc() just lets go
+  // of the table, after the tree has been cleared.
+  void releaseToc();
+  void dropToc();
+
+  // links the holders of entries pointing at the same stored data,
+  // so it's only loaded (and unpacked) once
+  void shareDuplicates();
+  void shareDuplicates(Folder* folder, std::map<FileOffset, DataHolder*>& seen);
+
+  const Entity* findEntity(const WideChar* path, size_t length) const;
 
   Folder* getFolder(std::vector<WideString>& names, bool forceCreate = true);
   Entity* getEntity(WideString& path) { return NULL; };
@@ -50,14 +114,55 @@ public:
   const WideString& getFileName() const;
 
   bool saveToFile(WideString& fileName);
-  bool loadFromFile(WideString& fileName);
+  // with demandLoad set, only the structures are read. file data is
+  // then read from the archive the first time it's asked for. if the
+  // archive can't be loaded, whatever was loaded before is kept.
+  bool loadFromFile(WideString& fileName, const bool demandLoad = false);
+
+  // loads the data of the given files with as few reads as possible,
+  // see BatchLoader. meant for demand-loaded volumes, e.g. to bring a
+  // level's files in at once. returns how many were loaded.
+  int loadBatch(const std::vector<WideString>& paths);
+  int loadBatch(Folder* folder, const bool recursive = true);
+
+  // supports demand-loading, safe to call from several threads
+  virtual PByte Load(FileOffset offset, size_t size);
+  virtual bool Read(FileOffset offset, size_t size, PByte dest);
+  virtual bool CanLoad();
 
 protected:
-  void loadFileData(Folder* folder, std::ifstream& source);
-  void loadFileData(File* file, std::ifstream& source);
+  void closeSource();
 
 private:
   WideString m_FileName;
+  HANDLE m_Source;    // the archive, open while demand-loading
+};
+
+/**
+ * mounts a saved volume without reading it.  the archive is memory
+ * mapped and every file's data holder points directly into the mapping,
+ * so nothing is copied and pages only come in when first touched.
+ * volumes mounting the same archive share a single mapping.
+ */
+class ReadOnlyVolume : public Volume
+{
+public:
+  ReadOnlyVolume();
+  virtual ~ReadOnlyVolume();
+
+  // a failed mount leaves the volume as it was
+  bool mount(const WideString& fileName);
+  void unmount();
+
+  const bool isMounted() const;
+  const WideString& getFileName() const;
+
+protected:
+  bool referenceFileData(Folder* folder, MappedFile* mapping);
+  bool referenceFileData(File* file, MappedFile* mapping);
+
+private:
+  MappedFile* m_Mapping;
 };
 
   } /* namespace vfs */
@@ -0,0 +1,330 @@
+/*
+Yet Another Game Library
+Copyright (c) 2001-2007, Virgilio A. Blones, Jr. (vij_blones_jr@yahoo.com)
+See https://sourceforge.net/projects/yaglib/ for the latest updates.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, 
+      this list of conditions and the following disclaimer.
+      
+    * Redistributions in binary form must reproduce the above copyright notice, 
+      this list of conditions and the following disclaimer in the documentation 
+      and/or other materials provided with the distribution.
+      
+    * Neither the name of this library (YAGLib) nor the names of its contributors 
+      may be used to endorse or promote products derived from this software 
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "GjDefs.h"
+#include "GjUnicodeUtils.h"
+#include "GjBFS.h"
+#include "GjSettings.h"
+#include "GjIniFiles.h"
+#include "GjResourceManagement.h"
+#include "GjResourceManifest.h"
+#include "GjVFSResourceStore.h"
+#include "GjMetaData.h"
+#include "GjStringUtils.h"
+#include <boost/algorithm/string.hpp>
+#include <iostream>
+#include <iomanip>
+
+#pragma comment(lib, "YAGSupport.lib")
+#pragma comment(lib, "YAGDisplay.lib")
+#pragma comment(lib, "YAGVFS.lib")
+
+using namespace yaglib;
+
+//
+// yrm: writes the resource manifest for a game's configuration.  run it
+// as part of the build, after the resource folders are in place; the
+// game picks the manifest up from the resource root at startup.
+//
+// with -bench, it times number parsing and formatting on the metadata
+// files instead, the scanf/printf way against string_utils::from_chars.
+/////////////////////////////////////////////////////////////////////////
+
+static void usage()
+{
+  std::wcout << L"usage: yrm [-bench] <config file> [resource root]" << std::endl;
+  std::wcout << L"       the resource root defaults to the config file's folder" << std::endl;
+}
+
+static bool startup(const WideString& configFile, const WideString& rootFolder)
+{
+  if(!bfs::is_file(configFile))
+  {
+    std::wcout << L"Config file " << configFile << L" does not exist" << std::endl;
+    return false;
+  }
+
+  GlobalSettings* gs = new GlobalSettings();
+  IniSettingsStore store;
+  gs->loadFrom(store, configFile);
+
+  // scan everything, an older manifest must not be used for this. the
+  // archives have to be opened the same way the game opens them, or the
+  // metadata in them is left out.
+  ResourceManager* rm = new ResourceManager();
+  rm->registerStore(VFS_ARCHIVE_EXTENSION, &vfs::VolumeStore::create);
+  if(!rm->initialize(gs->getSettings(), L"", false, rootFolder))
+  {
+    std::wcout << L"No " << CONFIG_FOLDERS_SECTION << L" section in " << configFile << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static void shutdown()
+{
+  delete ResourceManager::InstancePtr();
+  delete GlobalSettings::InstancePtr();
+}
+
+static int generate(const WideString& configFile, const WideString& rootFolder)
+{
+  if(!startup(configFile, rootFolder))
+  {
+    shutdown();
+    return 1;
+  }
+
+  MetaDataManager* metas = new MetaDataManager();
+  metas->initialize();
+
+  ResourceManifest manifest;
+  g_ResourceManager.writeManifest(manifest);
+  metas->writeManifest(manifest);
+
+  WideString manifestFile = rootFolder + L"\\" + RESOURCE_MANIFEST_FILENAME;
+  bool saved = manifest.save(manifestFile);
+  if(saved)
+    std::wcout << L"Wrote " << manifestFile << std::endl;
+  else
+    std::wcout << L"Unable to write " << manifestFile << std::endl;
+
+  delete metas;
+  shutdown();
+  return saved ? 0 : 1;
+}
+
+// every comma separated number in the metadata files, the way the 
+// loaders see them
+static void collectFields(const WideString& fileName, std::vector<WideString>& fields)
+{
+  DataPacks packs;
+  g_ResourceManager.lookup(packs, fileName);
+  for(DataPacks::iterator iter = packs.begin(); iter != packs.end(); iter++)
+  {
+    IniSettings ini(static_cast<const char*>(iter->getData()), iter->getSize());
+    for(int i = 0; i < static_cast<int>(ini.size()); i++)
+    {
+      Settings const& section = ini[i];
+      for(int j = 0; j < static_cast<int>(section.size()); j++)
+      {
+        std::vector<WideString> items;
+        boost::split(items, section[j].getValue(), boost::is_any_of(L","), boost::token_compress_on);
+        for(std::vector<WideString>::iterator item = items.begin(); item != items.end(); item++)
+        {
+          boost::trim(*item);
+          if(!item->empty() && ((((*item)[0] >= '0') && ((*item)[0] <= '9')) || ((*item)[0] == '-')))
+            fields.push_back(*item);
+        }
+      }
+    }
+  }
+}
+
+// string_utils as it was before from_chars
+static double scanInt(const WideString& field)
+{
+  int result = 0;
+  _stscanf(field.c_str(), L"%d", &result);
+  return result;
+}
+
+static double scanDouble(const WideString& field)
+{
+  double result = 0.0;
+  _stscanf(field.c_str(), L"%lf", &result);
+  return result;
+}
+
+static size_t printInt(const double value)
+{
+  char buf[32];
+  sprintf(buf, "%d", static_cast<int>(value));
+  return std::string(buf).size();
+}
+
+static size_t printDouble(const double value)
+{
+  char buf[336];
+  sprintf(buf, "%f", value);
+  return std::string(buf).size();
+}
+
+// and as it is now
+static double charsInt(const WideString& field)
+{
+  return string_utils::parse_int(field);
+}
+
+static double charsDouble(const WideString& field)
+{
+  return string_utils::parse_double(field);
+}
+
+static size_t formatInt(const double value)
+{
+  return string_utils::to_s<std::string>(static_cast<int>(value)).size();
+}
+
+static size_t formatDouble(const double value)
+{
+  return string_utils::to_s<std::string>(value).size();
+}
+
+typedef double (*FieldParser)(const WideString&);
+typedef size_t (*ValueFormatter)(const double);
+
+static LONGLONG ticks()
+{
+  LARGE_INTEGER result;
+  QueryPerformanceCounter(&result);
+  return result.QuadPart;
+}
+
+// nanoseconds per field
+static double timeParser(FieldParser parser, const std::vector<WideString>& fields, 
+  const int rounds, std::vector<double>& values)
+{
+  LARGE_INTEGER frequency;
+  QueryPerformanceFrequency(&frequency);
+
+  values.resize(fields.size());
+  LONGLONG started = ticks();
+  for(int round = 0; round < rounds; round++)
+    for(size_t i = 0; i < fields.size(); i++)
+      values[i] = parser(fields[i]);
+  LONGLONG elapsed = ticks() - started;
+
+  return elapsed * 1e9 / frequency.QuadPart / (static_cast<double>(rounds) * fields.size());
+}
+
+static double timeFormatter(ValueFormatter formatter, const std::vector<double>& values, const int rounds)
+{
+  LARGE_INTEGER frequency;
+  QueryPerformanceFrequency(&frequency);
+
+  size_t length = 0;
+  LONGLONG started = ticks();
+  for(int round = 0; round < rounds; round++)
+    for(size_t i = 0; i < values.size(); i++)
+      length += formatter(values[i]);
+  LONGLONG elapsed = ticks() - started;
+
+  // keeps the loop from being optimized away
+  if(length == 0)
+    std::wcout << L"";
+  return elapsed * 1e9 / frequency.QuadPart / (static_cast<double>(rounds) * values.size());
+}
+
+static void report(const wchar_t* what, const double before, const double after, const int differences)
+{
+  std::wcout << std::setw(16) << std::left << what << std::right << std::fixed << std::setprecision(1) <<
+    std::setw(10) << before << L" ns" << std::setw(10) << after << L" ns" << 
+    std::setw(8) << std::setprecision(2) << before / after << L"x";
+  if(differences > 0)
+    std::wcout << L"  (" << differences << L" results differ)";
+  std::wcout << std::endl;
+}
+
+static int countDifferences(const std::vector<double>& a, const std::vector<double>& b)
+{
+  int result = 0;
+  for(size_t i = 0; i < a.size(); i++)
+    if(a[i] != b[i])
+      result++;
+  return result;
+}
+
+static int benchmark(const WideString& configFile, const WideString& rootFolder)
+{
+  if(!startup(configFile, rootFolder))
+  {
+    shutdown();
+    return 1;
+  }
+
+  std::vector<WideString> fields;
+  collectFields(IMAGE_CONFIG_FILENAME, fields);
+  collectFields(SPRITES_CONFIG_FILENAME, fields);
+  shutdown();
+  if(fields.empty())
+  {
+    std::wcout << L"No numbers in the " << IMAGE_CONFIG_FILENAME << L" or " << 
+      SPRITES_CONFIG_FILENAME << L" files" << std::endl;
+    return 1;
+  }
+
+  // a million conversions or so, whatever the size of the corpus
+  int rounds = static_cast<int>(1000000 / fields.size()) + 1;
+  std::wcout << fields.size() << L" numbers, " << rounds << L" rounds" << std::endl;
+  std::wcout << std::setw(16) << L"" << std::setw(13) << L"scanf/printf" << std::setw(13) << L"from_chars" << std::endl;
+
+  std::vector<double> before, after;
+  double scanned = timeParser(&scanInt, fields, rounds, before);
+  double parsed = timeParser(&charsInt, fields, rounds, after);
+  report(L"parse int", scanned, parsed, countDifferences(before, after));
+  report(L"format int", timeFormatter(&printInt, after, rounds), timeFormatter(&formatInt, after, rounds), 0);
+
+  scanned = timeParser(&scanDouble, fields, rounds, before);
+  parsed = timeParser(&charsDouble, fields, rounds, after);
+  report(L"parse double", scanned, parsed, countDifferences(before, after));
+  report(L"format double", timeFormatter(&printDouble, after, rounds), timeFormatter(&formatDouble, after, rounds), 0);
+
+  return 0;
+}
+
+int _tmain(int argc, _TCHAR* argv[])
+{
+  int first = 1;
+  bool bench = (argc > 1) && (WideString(argv[1]) == L"-bench");
+  if(bench)
+    first++;
+
+  if(argc <= first)
+  {
+    usage();
+    return 1;
+  }
+
+  WideString configFile(argv[first]);
+  WideString rootFolder;
+  if(argc > first + 1)
+    rootFolder = argv[first + 1];
+  else
+  {
+    size_t slash = configFile.find_last_of(L"\\/");
+    rootFolder = (slash != WideString::npos) ? configFile.substr(0, slash) : WideString(L".");
+  }
+
+  return bench ? benchmark(configFile, rootFolder) : generate(configFile, rootFolder);
+}
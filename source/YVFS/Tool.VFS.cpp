@@ -0,0 +1,593 @@
+/*
+Yet Another Game Library
+Copyright (c) 2001-2007, Virgilio A. Blones, Jr. (vij_blones_jr@yahoo.com)
+See https://sourceforge.net/projects/yaglib/ for the latest updates.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, 
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, 
+      this list of conditions and the following disclaimer.
+      
+    * Redistributions in binary form must reproduce the above copyright notice, 
+      this list of conditions and the following disclaimer in the documentation 
+      and/or other materials provided with the distribution.
+      
+    * Neither the name of this library (YAGLib) nor the names of its contributors 
+      may be used to endorse or promote products derived from this software 
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "GjDefs.h"
+#include "GjUnicodeUtils.h"
+#include "GjStringUtils.h"
+#include "GjBFS.h"
+#include "GjVFS.h"
+#include <iostream>
+#include <fstream>
+#include <boost/bind.hpp>
+
+#pragma comment(lib, "YAGSupport.lib")
+#pragma comment(lib, "YAGVFS.lib")
+
+using namespace yaglib;
+using namespace yaglib::vfs;
+
+static double secondsNow()
+{
+  LARGE_INTEGER ticks, ticksPerSec;
+  QueryPerformanceCounter(&ticks);
+  QueryPerformanceFrequency(&ticksPerSec);
+  return (double)ticks.QuadPart / (double)ticksPerSec.QuadPart;
+}
+
+static void usage()
+{
+  std::wcout << L"usage: yvfs pack <source folder> <archive> [-lz] [-j <threads>]" << std::endl;
+  std::wcout << L"       yvfs stats <archive>" << std::endl;
+  std::wcout << L"       yvfs extract <archive> <path> <file>" << std::endl;
+  std::wcout << L"       yvfs verify <archive>" << std::endl;
+  std::wcout << L"       yvfs crcbench [megabytes]" << std::endl;
+  std::wcout << L"       yvfs loadbench <archive>" << std::endl;
+  std::wcout << L"       yvfs stress <archive> [-t <threads>] [-n <lookups>] [-cache <megabytes>] [-unpinned]" << std::endl;
+}
+
+//
+// pack: builds an archive out of a folder tree
+/////////////////////////////////////////////////
+
+static int pack(WideString sourceFolder, WideString archiveName, const int codec,
+  const int workerCount)
+{
+  if(!bfs::is_directory(sourceFolder))
+  {
+    std::wcout << L"Source folder " << sourceFolder << L" does not exist" << std::endl;
+    return 1;
+  }
+
+  ArchiveBuilder builder(workerCount);
+  builder.setCodec(codec);
+  builder.addFolder(L"", sourceFolder);
+
+  double start = secondsNow();
+  if(!builder.build(archiveName))
+  {
+    std::wcout << L"Unable to write " << archiveName << std::endl;
+    return 1;
+  }
+
+  wprintf(L"%d files, %.0f bytes stored as %.0f in %.2fs\n", builder.getFileCount(),
+    builder.getRawBytes(), builder.getStoredBytes(), secondsNow() - start);
+  wprintf(L"%d duplicates stored once, %.0f bytes saved\n", builder.getDuplicateCount(),
+    builder.getSavedBytes());
+  return 0;
+}
+
+//
+// stats: compression ratio and decode speed, per folder
+/////////////////////////////////////////////////////////
+
+struct FolderStats
+{
+  int files;
+  int packedFiles;
+  double rawBytes;
+  double storedBytes;
+  double decodedBytes;
+  double decodeSeconds;
+
+  FolderStats() : files(0), packedFiles(0), rawBytes(0), storedBytes(0),
+    decodedBytes(0), decodeSeconds(0) {};
+
+  void add(const FolderStats& other)
+  {
+    files += other.files;
+    packedFiles += other.packedFiles;
+    rawBytes += other.rawBytes;
+    storedBytes += other.storedBytes;
+    decodedBytes += other.decodedBytes;
+    decodeSeconds += other.decodeSeconds;
+  };
+};
+
+static void reportLine(const WideString& name, const FolderStats& stats)
+{
+  double ratio = (stats.storedBytes > 0) ? (stats.rawBytes / stats.storedBytes) : 1.0;
+  double speed = (stats.decodeSeconds > 0) ? 
+    (stats.decodedBytes / (1024.0 * 1024.0) / stats.decodeSeconds) : 0.0;
+  wprintf(L"%-40s %6d %6d %12.0f %12.0f %6.2f %9.1f\n", name.c_str(), stats.files, 
+    stats.packedFiles, stats.rawBytes, stats.storedBytes, ratio, speed);
+}
+
+static void reportFolder(Folder* folder, const WideString& path, FolderStats& total)
+{
+  // files directly inside this folder only, subfolders get their own line
+  FolderStats stats;
+  Files* files = folder->getFiles();
+  for(Entities::iterator iter = files->begin(); iter != files->end(); iter++)
+  {
+    File* file = dynamic_cast<File*>(*iter);
+    DataHolder* holder = file->getDataHolder();
+    stats.files++;
+    stats.rawBytes += holder->getDataSize();
+    stats.storedBytes += holder->getStoredSize();
+    if(holder->getCodec() == cCodecNone)
+      continue;
+
+    stats.packedFiles++;
+    double start = secondsNow();
+    bool decoded = (holder->getData() != NULL);
+    stats.decodeSeconds += secondsNow() - start;
+    if(decoded)
+      stats.decodedBytes += holder->getDataSize();
+    else
+      std::wcout << L"Failed to decode " << path << (*iter)->getName() << std::endl;
+    file->DropData();
+  }
+
+  if(stats.files > 0)
+    reportLine(path.empty() ? WideString(PATH_SEPARATOR) : path, stats);
+  total.add(stats);
+
+  Folders* folders = folder->getFolders();
+  for(Entities::iterator iter = folders->begin(); iter != folders->end(); iter++)
+    reportFolder(dynamic_cast<Folder*>(*iter), path + (*iter)->getName() + PATH_SEPARATOR, total);
+}
+
+static int stats(WideString archiveName)
+{
+  ReadOnlyVolume volume;
+  if(!volume.mount(archiveName))
+  {
+    std::wcout << L"Unable to mount " << archiveName << std::endl;
+    return 1;
+  }
+
+  wprintf(L"%-40s %6s %6s %12s %12s %6s %9s\n", L"folder", L"files", L"packed", 
+    L"raw", L"stored", L"ratio", L"MB/s");
+
+  FolderStats total;
+  reportFolder(&volume, L"", total);
+  reportLine(L"(total)", total);
+  return 0;
+}
+
+//
+// extract: copies one file out, a buffer at a time
+///////////////////////////////////////////////////
+
+static int extract(WideString archiveName, WideString path, WideString fileName)
+{
+  ReadOnlyVolume volume;
+  if(!volume.mount(archiveName))
+  {
+    std::wcout << L"Unable to mount " << archiveName << std::endl;
+    return 1;
+  }
+
+  const File* file = volume.findFile(path);
+  if(file == NULL)
+  {
+    std::wcout << path << L" is not in " << archiveName << std::endl;
+    return 1;
+  }
+
+  UTF8String utf8(fileName);
+  std::ofstream dest(utf8.c_str(), std::ios::binary|std::ios::out);
+  if(!dest.is_open())
+  {
+    std::wcout << L"Unable to write " << fileName << std::endl;
+    return 1;
+  }
+
+  FileStream stream(file);
+  if(!stream.isOpen())
+  {
+    std::wcout << path << L" failed its checksum" << std::endl;
+    return 1;
+  }
+  std::vector<char> buffer(cDefStreamBufferSize);
+  while(!stream.eof())
+  {
+    size_t count = stream.read(&buffer[0], buffer.size());
+    if(count == 0)
+    {
+      std::wcout << L"Unable to read " << path << std::endl;
+      return 1;
+    }
+    dest.write(&buffer[0], (std::streamsize)count);
+  }
+
+  return dest.good() ? 0 : 1;
+}
+
+//
+// verify: checks every file's stored data against its checksum
+/////////////////////////////////////////////////////////////////
+
+struct VerifyStats
+{
+  int checked;
+  int failed;
+  int unchecked;
+  double bytes;
+
+  VerifyStats() : checked(0), failed(0), unchecked(0), bytes(0) {};
+};
+
+static void verifyFolder(Folder* folder, const WideString& path, VerifyStats& stats)
+{
+  Folders* folders = folder->getFolders();
+  for(Entities::iterator iter = folders->begin(); iter != folders->end(); iter++)
+    verifyFolder(dynamic_cast<Folder*>(*iter), path + (*iter)->getName() + PATH_SEPARATOR, stats);
+
+  Files* files = folder->getFiles();
+  for(Entities::iterator iter = files->begin(); iter != files->end(); iter++)
+  {
+    DataHolder* holder = dynamic_cast<File*>(*iter)->getDataHolder();
+    if(!holder->hasChecksum())
+    {
+      stats.unchecked++;
+      continue;
+    }
+
+    stats.checked++;
+    stats.bytes += holder->getStoredSize();
+    if(!holder->verify())
+    {
+      stats.failed++;
+      std::wcout << L"Checksum mismatch: " << path << (*iter)->getName() << std::endl;
+    }
+  }
+}
+
+static int verify(WideString archiveName)
+{
+  ReadOnlyVolume volume;
+  if(!volume.mount(archiveName))
+  {
+    std::wcout << L"Unable to mount " << archiveName << std::endl;
+    return 1;
+  }
+
+  VerifyStats stats;
+  double start = secondsNow();
+  verifyFolder(&volume, PATH_SEPARATOR, stats);
+  double seconds = secondsNow() - start;
+
+  wprintf(L"%d files checked, %d failed, %d without checksums\n", stats.checked,
+    stats.failed, stats.unchecked);
+  wprintf(L"%.0f bytes in %.2fs, %.1f MB/s\n", stats.bytes, seconds,
+    (seconds > 0) ? (stats.bytes / (1024.0 * 1024.0) / seconds) : 0.0);
+  return (stats.failed > 0) ? 1 : 0;
+}
+
+//
+// crcbench: checksum throughput, with and without the hardware
+////////////////////////////////////////////////////////////////
+
+static double crcThroughput(std::vector<Byte>& buffer, const bool portable, unsigned int& crc)
+{
+  // a few rounds, so the timer's resolution doesn't matter
+  const int rounds = 8;
+  double start = secondsNow();
+  for(int i = 0; i < rounds; i++)
+    crc = portable ? checksum::crc32cPortable(&buffer[0], buffer.size()) :
+      checksum::crc32c(&buffer[0], buffer.size());
+  double seconds = secondsNow() - start;
+  return (seconds > 0) ? ((double)buffer.size() * rounds / (1024.0 * 1024.0) / seconds) : 0.0;
+}
+
+static int crcbench(const int megabytes)
+{
+  std::vector<Byte> buffer((size_t)megabytes * 1024 * 1024);
+  unsigned int seed = 12345;
+  for(size_t i = 0; i < buffer.size(); i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    buffer[i] = (Byte)(seed >> 16);
+  }
+
+  unsigned int fast, portable;
+  double fastSpeed = crcThroughput(buffer, false, fast);
+  double portableSpeed = crcThroughput(buffer, true, portable);
+
+  wprintf(L"SSE4.2 CRC32: %s\n", checksum::hasHardwareSupport() ? L"yes" : L"no");
+  wprintf(L"%-10s %10.1f MB/s  %08x\n", L"crc32c", fastSpeed, fast);
+  wprintf(L"%-10s %10.1f MB/s  %08x\n", L"portable", portableSpeed, portable);
+  return (fast == portable) ? 0 : 1;
+}
+
+//
+// stress: many threads looking up and reading from one volume
+///////////////////////////////////////////////////////////////
+
+struct StressTarget
+{
+  WideString path;
+  WideString qualifiedName;
+  size_t size;
+  unsigned int checksum;
+};
+typedef std::vector<StressTarget> StressTargets;
+
+struct StressRun
+{
+  const Volume* volume;
+  DataCache* cache;
+  const StressTargets* targets;
+  int lookups;
+  bool unpinned;
+  volatile LONG failures;
+};
+
+static void collectTargets(Folder* folder, const WideString& path, StressTargets& targets)
+{
+  Folders* folders = folder->getFolders();
+  for(Entities::iterator iter = folders->begin(); iter != folders->end(); iter++)
+    collectTargets(dynamic_cast<Folder*>(*iter), path + (*iter)->getName() + PATH_SEPARATOR, targets);
+
+  Files* files = folder->getFiles();
+  for(Entities::iterator iter = files->begin(); iter != files->end(); iter++)
+  {
+    File* file = dynamic_cast<File*>(*iter);
+    DataHolder* holder = file->getDataHolder();
+    PByte data = holder->getData();
+    if((data == NULL) && (holder->getDataSize() > 0))
+      continue;
+
+    StressTarget target;
+    target.path = path + file->getName();
+    target.qualifiedName = file->getQualifiedName();
+    target.size = holder->getDataSize();
+    target.checksum = checksum::crc32c(data, target.size);
+    targets.push_back(target);
+    file->DropData();
+  }
+}
+
+static void stressWorker(StressRun* run, unsigned int seed)
+{
+  for(int i = 0; i < run->lookups; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    const StressTarget& target = (*run->targets)[(seed >> 8) % run->targets->size()];
+
+    const File* file = run->volume->findFile(target.path);
+    if((file == NULL) || (file->getQualifiedName() != target.qualifiedName))
+    {
+      InterlockedIncrement(&run->failures);
+      continue;
+    }
+
+    // unpinned reads race the other threads' evictions on purpose
+    DataHolder* holder = file->getDataHolder();
+    bool pinned = (run->cache != NULL) && !run->unpinned;
+    PByte data = pinned ? run->cache->acquire(holder) : holder->getData();
+    bool good = ((data != NULL) || (target.size == 0)) && (holder->getDataSize() == target.size) &&
+      (checksum::crc32c(data, target.size) == target.checksum);
+    if(pinned)
+      run->cache->release(holder);
+
+    if(!good)
+      InterlockedIncrement(&run->failures);
+  }
+}
+
+static int stress(WideString archiveName, const int threadCount, const int lookups,
+  const int cacheMegabytes, const bool unpinned)
+{
+  // what every file should read as, worked out on a volume of its own so
+  // the one under test starts out with nothing created or loaded
+  StressTargets targets;
+  {
+    ReadOnlyVolume reference;
+    if(!reference.mount(archiveName))
+    {
+      std::wcout << L"Unable to mount " << archiveName << std::endl;
+      return 1;
+    }
+    collectTargets(&reference, PATH_SEPARATOR, targets);
+  }
+  if(targets.empty())
+  {
+    std::wcout << archiveName << L" has no files to read" << std::endl;
+    return 1;
+  }
+
+  DataCache cache((size_t)cacheMegabytes * 1024 * 1024);
+  ReadOnlyVolume volume;
+  if(!volume.mount(archiveName))
+  {
+    std::wcout << L"Unable to mount " << archiveName << std::endl;
+    return 1;
+  }
+  volume.setVerify(true);
+  if(cacheMegabytes > 0)
+    volume.setCache(&cache);
+
+  StressRun run;
+  run.volume = &volume;
+  run.cache = (cacheMegabytes > 0) ? &cache : NULL;
+  run.targets = &targets;
+  run.unpinned = unpinned;
+  run.failures = 0;
+
+  // unpinned runs go in rounds, reclaiming in between like a game
+  // would between frames, when nobody holds on to any data
+  const int rounds = (unpinned && (run.cache != NULL)) ? 4 : 1;
+  run.lookups = lookups / rounds;
+  size_t retiredBytes = 0;
+
+  double start = secondsNow();
+  {
+    WorkerPool pool(threadCount);
+    for(int round = 0; round < rounds; round++)
+    {
+      for(int i = 0; i < pool.getWorkerCount(); i++)
+        pool.submit(boost::bind(&stressWorker, &run, (unsigned int)((round * 31 + i) * 7919 + 1)));
+      pool.wait();
+      if(retiredBytes < cache.getRetiredBytes())
+        retiredBytes = cache.getRetiredBytes();
+      cache.reclaim();
+    }
+    wprintf(L"%d threads, %d lookups each, %d files\n", pool.getWorkerCount(),
+      run.lookups * rounds, (int)targets.size());
+  }
+  double seconds = secondsNow() - start;
+
+  wprintf(L"%.2fs, %d failures\n", seconds, (int)run.failures);
+  if(run.cache != NULL)
+    wprintf(L"cache: %ld hits, %ld misses, %ld evictions\n", cache.getHits(),
+      cache.getMisses(), cache.getEvictions());
+  if((run.cache != NULL) && unpinned)
+    wprintf(L"at most %d KB retired between reclaims\n", (int)(retiredBytes / 1024));
+
+  return (run.failures > 0) ? 1 : 0;
+}
+
+//
+// loadbench: loading every file one at a time, and as a single batch
+///////////////////////////////////////////////////////////////////////
+
+static double loadOneByOne(Folder* folder)
+{
+  double bytes = 0;
+  Folders* folders = folder->getFolders();
+  for(Entities::iterator iter = folders->begin(); iter != folders->end(); iter++)
+    bytes += loadOneByOne(dynamic_cast<Folder*>(*iter));
+
+  Files* files = folder->getFiles();
+  for(Entities::iterator iter = files->begin(); iter != files->end(); iter++)
+  {
+    DataHolder* holder = dynamic_cast<File*>(*iter)->getDataHolder();
+    if(holder->getData() != NULL)
+      bytes += holder->getStoredSize();
+  }
+  return bytes;
+}
+
+static int loadbench(WideString archiveName)
+{
+  // a fresh volume for each, so neither finds anything already loaded.
+  // the first pass is from a cold OS cache for the one-by-one loads
+  // only, the second one compares them on equal terms.
+  for(int pass = 0; pass < 2; pass++)
+  {
+    wprintf(L"pass %d\n", pass + 1);
+    ReadWriteVolume single;
+    if(!single.loadFromFile(archiveName, true))
+    {
+      std::wcout << L"Unable to load " << archiveName << std::endl;
+      return 1;
+    }
+    double start = secondsNow();
+    double bytes = loadOneByOne(&single);
+    double singleSeconds = secondsNow() - start;
+
+    ReadWriteVolume batched;
+    batched.loadFromFile(archiveName, true);
+    BatchLoader batch(archiveName);
+    batch.add(&batched);
+    start = secondsNow();
+    int loaded = batch.load();
+    double batchSeconds = secondsNow() - start;
+
+    wprintf(L"one by one: %.0f bytes in %.3fs, %.1f MB/s\n", bytes, singleSeconds,
+      (singleSeconds > 0) ? (bytes / (1024.0 * 1024.0) / singleSeconds) : 0.0);
+    wprintf(L"batched:    %d files in %d reads, %.0f bytes in %.3fs, %.1f MB/s\n", loaded,
+      batch.getReadCount(), batch.getBytesRead(), batchSeconds,
+      (batchSeconds > 0) ? (batch.getBytesRead() / (1024.0 * 1024.0) / batchSeconds) : 0.0);
+  }
+  return 0;
+}
+
+int _tmain(int argc, _TCHAR* argv[])
+{
+  WideString command = (argc > 1) ? WideString(argv[1]) : WideString(L"");
+  if((command == L"pack") && (argc > 3))
+  {
+    int codec = cCodecNone;
+    int workerCount = 0;
+    for(int i = 4; i < argc; i++)
+    {
+      WideString option(argv[i]);
+      if(option == L"-lz")
+        codec = cCodecLZ;
+      else if((option == L"-j") && (i + 1 < argc))
+        workerCount = _wtoi(argv[++i]);
+    }
+    return pack(argv[2], argv[3], codec, workerCount);
+  }
+  if((command == L"stats") && (argc > 2))
+    return stats(argv[2]);
+  if((command == L"extract") && (argc > 4))
+    return extract(argv[2], argv[3], argv[4]);
+  if((command == L"verify") && (argc > 2))
+    return verify(argv[2]);
+  if((command == L"loadbench") && (argc > 2))
+    return loadbench(argv[2]);
+  if((command == L"stress") && (argc > 2))
+  {
+    int threadCount = 0;
+    int lookups = 100000;
+    int cacheMegabytes = 0;
+    bool unpinned = false;
+    for(int i = 3; i < argc; i++)
+    {
+      WideString option(argv[i]);
+      if(option == L"-unpinned")
+        unpinned = true;
+      else if(i + 1 >= argc)
+        break;
+      else if(option == L"-t")
+        threadCount = _wtoi(argv[++i]);
+      else if(option == L"-n")
+        lookups = _wtoi(argv[++i]);
+      else if(option == L"-cache")
+        cacheMegabytes = _wtoi(argv[++i]);
+    }
+    return stress(argv[2], threadCount, lookups, cacheMegabytes, unpinned);
+  }
+  if(command == L"crcbench")
+  {
+    int megabytes = (argc > 2) ? _wtoi(argv[2]) : 0;
+    return crcbench((megabytes > 0) ? megabytes : 64);
+  }
+
+  usage();
+  return 1;
+}
@@ -43,9 +43,9 @@ nukeDriveSpec = false #(ARGV.size > 0) and (ARGV[0] =~ /MinGW/)
 
 # place all the source directories in this array
 # IMPORTANT: pre-requisite library MUST be preceded their dependents!
-lib_sources = ["YAGSupport", "YAGInput", "YAGDisplay", "YAGCore"]
+lib_sources = ["YAGSupport", "YAGVFS", "YAGInput", "YAGDisplay", "YAGCore"]
 gui_apps = ["TApplication", "TGameBasic", "TGameApplication", "TGameExtended", "PyramidSolitaire"]
-console_apps = ["yipp"]
+console_apps = ["yipp", "yvfs", "yrm"]
 extra_lib_sources = ["3rdParty/FreeImage", "3rdParty/FreeSL/lib"]
 extra_includes = ["3rdParty/FreeImage", "3rdParty/FreeSL/include"]
 